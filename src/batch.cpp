@@ -0,0 +1,245 @@
+#include "batch.h"
+
+#include <cassert>
+#include <algorithm>
+#include <numeric>
+
+// column holds rows of batch lanes of width entries each
+template<class T>
+static void permuteColumn(std::vector<T>& column, int batch, int width, const std::vector<int>& from) {
+    std::vector<T> old = column;
+    int rows = column.size() / (batch * width);
+    for (int r = 0; r < rows; ++r)
+        for (int l = 0; l < batch; ++l)
+            for (int k = 0; k < width; ++k)
+                column[(r * batch + l) * width + k] = old[(r * batch + from[l]) * width + k];
+}
+
+void BatchSim::reset(const std::vector<ExactTaskSet>& task_sets, Policy policy, int cores) {
+    this->policy = policy;
+    this->cores = cores;
+    batch = task_sets.size();
+    tasks = 0;
+    for (const ExactTaskSet& task_set : task_sets)
+        tasks = std::max(tasks, (int)task_set.size());
+
+    time.assign(batch, 0);
+    time_scale.assign(batch, 1);
+    missed.assign(batch, -1);
+    cswitch_count.assign(batch, 0);
+    migration_count.assign(batch, 0);
+    finished_count.assign(batch, 0);
+    core_task.assign(batch * cores, -1);
+    instance.resize(batch);
+    std::iota(instance.begin(), instance.end(), 0);
+
+    int n = tasks * batch;
+    period.assign(n, TIME_MAX);
+    exec_time.assign(n, 0);
+    relative_deadline.assign(n, 0);
+    static_key.assign(n, TIME_MAX);
+    next_release.assign(n, TIME_MAX);
+    deadline.assign(n, TIME_MAX);
+    remaining.assign(n, 0);
+    active.assign(n, false);
+    running.assign(n, false);
+    chosen.assign(n, false);
+    core.assign(n, -1);
+    for (int b = 0; b < batch; ++b) {
+        time_scale[b] = tickScale(task_sets[b]);
+        for (int t = 0; t < task_sets[b].size(); ++t) {
+            const auto& task = task_sets[b][t];
+            assert(task.relative_deadline <= task.period);
+            int i = t * batch + b;
+            period[i] = toTime(task.period, time_scale[b]);
+            exec_time[i] = toTime(task.exec_time, time_scale[b]);
+            relative_deadline[i] = toTime(task.relative_deadline, time_scale[b]);
+            static_key[i] = std::min(period[i], relative_deadline[i]);
+            next_release[i] = toTime(task.phase, time_scale[b]);
+        }
+    }
+}
+
+void BatchSim::permuteLanes(const std::vector<int>& from) {
+    auto lane = [&](auto& column) { permuteColumn(column, batch, 1, from); };
+    lane(time); lane(time_scale); lane(missed);
+    lane(cswitch_count); lane(migration_count); lane(finished_count);
+    permuteColumn(core_task, batch, cores, from);
+    lane(period); lane(exec_time); lane(relative_deadline); lane(static_key);
+    lane(next_release); lane(deadline); lane(remaining);
+    lane(active); lane(running); lane(chosen); lane(core);
+    lane(instance); lane(end_time); lane(done);
+}
+
+void BatchSim::choose() {
+    std::fill(chosen.begin(), chosen.end(), false);
+    best_key.resize(batch);
+    best_task.resize(batch);
+    best_running.resize(batch);
+    picked.resize(cores * batch);
+
+    // hot loops go through raw pointers so the vectorizer can see the columns don't alias the bounds
+    const int lanes = live, stride = batch;
+    const Time* keys = policy == GLOBAL_EDF ? deadline.data() : static_key.data();
+    const int* is_active = active.data();
+    const int* is_running = running.data();
+    int* is_chosen = chosen.data();
+    Time* key = best_key.data();
+    int* task = best_task.data();
+    int* key_running = best_running.data();
+    for (int c = 0; c < cores; ++c) {
+        std::fill(best_key.begin(), best_key.end(), TIME_MAX);
+        std::fill(best_task.begin(), best_task.end(), -1);
+        std::fill(best_running.begin(), best_running.end(), false);
+        for (int t = 0; t < tasks; ++t) {
+            for (int b = 0; b < lanes; ++b) {
+                int i = t * stride + b;
+                bool better = is_active[i] & !is_chosen[i] & ((keys[i] < key[b]) | ((keys[i] == key[b]) & (is_running[i] > key_running[b])));
+                key[b] = better ? keys[i] : key[b];
+                task[b] = better ? t : task[b];
+                key_running[b] = better ? is_running[i] : key_running[b];
+            }
+        }
+        for (int b = 0; b < lanes; ++b) {
+            if (task[b] != -1) is_chosen[task[b] * stride + b] = true;
+            picked[c * stride + b] = task[b];
+        }
+    }
+}
+
+void BatchSim::assignCores() {
+    std::vector<int> next_task(cores);
+    for (int b = 0; b < live; ++b) {
+        if (done[b]) continue;
+        int* core_state = &core_task[b * cores];
+
+        // drop jobs that completed since the last decision, then chosen jobs already executing stay put (mitigates context switches)
+        for (int c = 0; c < cores; ++c) {
+            int t = core_state[c];
+            if (t != -1 && !running[t * batch + b]) core_state[c] = t = -1;
+            next_task[c] = t != -1 && chosen[t * batch + b] ? t : -1;
+        }
+
+        // other chosen jobs go to the core they last ran on if it is free (mitigates job-level migrations), else the first free core
+        for (int k = 0; k < cores; ++k) {
+            int t = picked[k * batch + b];
+            int i = t * batch + b;
+            if (t == -1 || running[i]) continue;
+            int c = core[i] != -1 && next_task[core[i]] == -1 ? core[i] : -1;
+            if (c == -1)
+                while (next_task[++c] != -1);
+            migration_count[b] += core[i] != -1 && core[i] != c;
+            core[i] = c;
+            next_task[c] = t;
+        }
+        for (int c = 0; c < cores; ++c)
+            if (core_state[c] != -1) running[core_state[c] * batch + b] = false;
+        for (int c = 0; c < cores; ++c) {
+            cswitch_count[b] += core_state[c] != next_task[c];
+            core_state[c] = next_task[c];
+            if (next_task[c] != -1) running[next_task[c] * batch + b] = true;
+        }
+    }
+}
+
+void BatchSim::sim(Fraction endTime) {
+    end_time.resize(batch);
+    done.resize(batch);
+    next_event.resize(batch);
+    for (int b = 0; b < batch; ++b) {
+        end_time[b] = toTime(endTime, time_scale[b]);
+        done[b] = missed[b] != -1 || time[b] >= end_time[b];
+    }
+    std::vector<int> from(batch);
+    live = batch;
+    while (true) {
+        // once a quarter of the live lanes are done, move them behind the rest
+        int done_count = std::count(done.begin(), done.begin() + live, true);
+        if (done_count > 0 && done_count * 4 >= live) {
+            std::iota(from.begin(), from.end(), 0);
+            std::stable_partition(from.begin(), from.begin() + live, [&](int l) { return !done[l]; });
+            permuteLanes(from);
+            live -= done_count;
+        }
+        if (live == 0) break;
+        const int lanes = live, stride = batch;
+        const Time* now = time.data();
+        const int* lane_done = done.data();
+        Time* release_at = next_release.data();
+        Time* due = deadline.data();
+        Time* left = remaining.data();
+        Time* next = next_event.data();
+        int* is_active = active.data();
+        int* is_running = running.data();
+        const int* is_chosen = chosen.data();
+
+        // handle job releases by time
+        // (the loops are split so each touches few enough columns for the vectorizer's runtime alias checks)
+        for (int t = 0; t < tasks; ++t) {
+            const Time* exec = exec_time.data() + t * stride;
+            int* last_core = core.data() + t * stride;
+            for (int b = 0; b < lanes; ++b) {
+                int i = t * stride + b;
+                bool release = !lane_done[b] & (release_at[i] <= now[b]);
+                is_active[i] |= release;
+                left[i] = release ? exec[b] : left[i];
+                last_core[b] = release ? -1 : last_core[b];
+            }
+            const Time* rel_deadline = relative_deadline.data() + t * stride;
+            const Time* task_period = period.data() + t * stride;
+            for (int b = 0; b < lanes; ++b) {
+                int i = t * stride + b;
+                bool release = !lane_done[b] & (release_at[i] <= now[b]);
+                due[i] = release ? release_at[i] + rel_deadline[b] : due[i];
+                release_at[i] += release ? task_period[b] : 0;
+            }
+        }
+
+        // schedule
+        choose();
+        assignCores();
+
+        // next event is the earliest release, deadline or completion
+        std::fill(next_event.begin(), next_event.end(), TIME_MAX);
+        for (int t = 0; t < tasks; ++t) {
+            for (int b = 0; b < lanes; ++b) {
+                int i = t * stride + b;
+                Time completion = is_chosen[i] ? now[b] + left[i] : TIME_MAX;
+                next[b] = std::min(next[b], std::min(std::min(release_at[i], due[i]), completion));
+            }
+        }
+
+        // execute chosen jobs up to the next event + handle completions and misses
+        long long* finished = finished_count.data();
+        int* miss = missed.data();
+        for (int t = 0; t < tasks; ++t) {
+            for (int b = 0; b < lanes; ++b) {
+                int i = t * stride + b;
+                bool run = is_chosen[i] & !lane_done[b];
+                left[i] -= run ? next[b] - now[b] : 0;
+            }
+            for (int b = 0; b < lanes; ++b) {
+                int i = t * stride + b;
+                bool complete = is_chosen[i] & !lane_done[b] & (left[i] == 0);
+                is_active[i] &= !complete;
+                is_running[i] &= !complete;
+                finished[b] += complete;
+            }
+            for (int b = 0; b < lanes; ++b) {
+                int i = t * stride + b;
+                due[i] = is_active[i] ? due[i] : TIME_MAX;
+                miss[b] = is_active[i] & !lane_done[b] & (due[i] <= next[b]) ? t : miss[b];
+            }
+        }
+        for (int b = 0; b < lanes; ++b) {
+            if (done[b]) continue;
+            time[b] = next_event[b];
+            done[b] = missed[b] != -1 || time[b] >= end_time[b];
+        }
+    }
+
+    // put instances back in their own lanes
+    for (int l = 0; l < batch; ++l)
+        from[instance[l]] = l;
+    permuteLanes(from);
+}
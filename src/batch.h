@@ -0,0 +1,66 @@
+#include "model.h"
+
+#ifndef BATCH_H
+#define BATCH_H
+
+// simulates many task sets in lockstep under one global fixed job priority policy
+// job state is stored task-major (index task * batch + instance) so every step is a loop over the batch that vectorizes
+// with MARISA_TICK_TIME (given a target with 64-bit vector compares, e.g. -march=x86-64-v3)
+// every task needs relative_deadline <= period, so each task has at most one active job (a second one means a miss)
+struct BatchSim {
+    enum Policy { GLOBAL_EDF, GLOBAL_DM };
+
+    Policy policy = GLOBAL_EDF;
+    int cores = 1;
+    int batch = 0; // number of task sets
+    int tasks = 0; // tasks per instance (shorter task sets are padded with tasks that never release)
+
+    // per instance
+    std::vector<Time> time;
+    std::vector<long long> time_scale; // model time units per task set time unit
+    std::vector<int> missed; // task that missed its deadline (-1 if none)
+    std::vector<long long> cswitch_count;
+    std::vector<long long> migration_count;
+    std::vector<long long> finished_count;
+    std::vector<int> core_task; // core_task[instance * cores + core] = task running on core (-1 if idle)
+
+    // per task x instance
+    std::vector<Time> period;
+    std::vector<Time> exec_time;
+    std::vector<Time> relative_deadline;
+    std::vector<Time> static_key; // GLOBAL_DM priority (lower runs first)
+    std::vector<Time> next_release;
+    std::vector<Time> deadline; // deadline of the active job (TIME_MAX if none)
+    std::vector<Time> remaining; // work left on the active job
+    std::vector<int> active;
+    std::vector<int> running; // on a core since the last decision
+    std::vector<int> chosen; // picked by the current decision
+    std::vector<int> core; // core the active job last ran on (-1 if not executed yet)
+
+    BatchSim() {}
+
+    // reset and load one instance per task set
+    void reset(const std::vector<ExactTaskSet>& task_sets, Policy policy, int cores);
+
+    // simulate every instance to at least endTime, or until it misses
+    void sim(Fraction endTime);
+
+private:
+    // sim() keeps unfinished instances in the first live lanes so finished ones stop costing work
+    int live = 0;
+    std::vector<int> instance; // instance held by each lane
+    std::vector<Time> end_time, best_key, next_event;
+    std::vector<int> best_task, picked; // picked[core pass * batch + lane] = task chosen in that pass (-1 if none)
+    std::vector<int> best_running, done;
+
+    // lane l takes the state of lane from[l]
+    void permuteLanes(const std::vector<int>& from);
+
+    // pick the job for each core (lowest key, running jobs win ties, then lower task)
+    void choose();
+
+    // move chosen jobs onto cores and count context switches and migrations
+    void assignCores();
+};
+
+#endif
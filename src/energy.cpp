@@ -0,0 +1,83 @@
+#include "energy.h"
+
+#include <algorithm>
+#include <cmath>
+
+// entry of a per core list, cores past the end take the last entry
+static double byCore(const std::vector<double>& values, int core) {
+    assert(!values.empty());
+    return values[std::min(core, (int)values.size() - 1)];
+}
+
+static double toDouble(Fraction value) {
+    return (double)value.getNum() / value.getDen();
+}
+
+double PowerModel::activePower(int core, Fraction speed) const {
+    double s = toDouble(speed);
+    return byCore(static_power, core) + byCore(dynamic_power, core) * s * s * s;
+}
+
+double PowerModel::idlePower(int core) const {
+    return byCore(idle_power, core);
+}
+
+double EnergyMeter::elapsed(const SimModel& model) const {
+    return toDouble(model.toExact(model.origin + model.time));
+}
+
+double EnergyMeter::idleEnergy(const SimModel& model, int core) const {
+    return std::max(0.0, elapsed(model) - busy_time[core]) * power.idlePower(core);
+}
+
+double EnergyMeter::energy(const SimModel& model, int core) const {
+    return active_energy[core] + idleEnergy(model, core);
+}
+
+double EnergyMeter::energy(const SimModel& model) const {
+    double total = 0;
+    for (int c = 0; c < busy_time.size(); ++c)
+        total += energy(model, c);
+    return total;
+}
+
+void EnergyMeter::onReset(const SimModel& model, const ExactTaskSet& task_set) {
+    busy_time.assign(model.cores, 0);
+    active_energy.assign(model.cores, 0);
+}
+
+void EnergyMeter::onExec(const SimModel& model, const ExecBlock& block) {
+    // blocks run within one decision, at the speed their core has until the next one
+    double duration = toDouble(model.toExact(block.end - block.start));
+    busy_time[block.core] += duration;
+    active_energy[block.core] += duration * power.activePower(block.core, model.core_speed[block.core]);
+}
+
+void DensityDvfsPolicy::setSpeeds(const SimModel& model, std::vector<Fraction>& speed) const {
+    // in doubles, exact sums over many jobs overflow
+    double total_speed = 0, min_speed = INFINITY;
+    for (int c = 0; c < model.cores; ++c) {
+        double top = c < model.speeds.size() ? toDouble(model.speeds[c]) : 1;
+        total_speed += top;
+        min_speed = std::min(min_speed, top);
+    }
+    double total_density = 0, max_density = 0;
+    bool late = false;
+    for (JobView job : model.active_jobs) {
+        // a running job first gets through any switching overhead left
+        Time window = job.deadline() - model.time - job.overhead();
+        if (window <= 0) {
+            late = true;
+            break;
+        }
+        double density = toDouble(model.toExact(job.exec_time() - job.runtime())) / toDouble(model.toExact(window));
+        total_density += density;
+        max_density = std::max(max_density, density);
+    }
+    double needed = std::max(total_density / total_speed, max_density / min_speed);
+    int level = late ? levels.size() - 1 : 0;
+    while (level + 1 < levels.size() && toDouble(levels[level]) < needed)
+        ++level;
+    for (int c = 0; c < model.cores; ++c)
+        speed[c] = (c < model.speeds.size() ? model.speeds[c] : Fraction(1)) * levels[level];
+}
\ No newline at end of file
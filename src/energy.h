@@ -0,0 +1,53 @@
+#include "model.h"
+#include <vector>
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+// power drawn by each core, in energy per task set time unit
+// a busy core at speed s draws static_power + dynamic_power * s^3 (voltage scales with frequency), an idle core draws idle_power
+// entries are by core, cores past the end take the last entry (so one entry covers identical cores)
+struct PowerModel {
+    std::vector<double> static_power = {0};
+    std::vector<double> dynamic_power = {1};
+    std::vector<double> idle_power = {0};
+
+    double activePower(int core, Fraction speed) const;
+    double idlePower(int core) const;
+};
+
+// integrates the energy of each core over exec blocks (switching overhead counts as busy), the rest of the simulated time is idle
+// attach to SimModel::observers before reset, totals cover the run since the last reset (not carried over by fork or restore)
+class EnergyMeter : public SimObserver {
+public:
+    PowerModel power;
+    std::vector<double> busy_time; // by core, in task set time units
+    std::vector<double> active_energy; // by core
+
+    EnergyMeter(const PowerModel& power = PowerModel()) : power(power) {}
+
+    // time simulated since the reset in task set time units
+    double elapsed(const SimModel& model) const;
+
+    // energy used by core up to the model's time
+    double idleEnergy(const SimModel& model, int core) const;
+    double energy(const SimModel& model, int core) const;
+
+    // energy used by every core up to the model's time
+    double energy(const SimModel& model) const;
+
+    void onReset(const SimModel& model, const ExactTaskSet& task_set) override;
+    void onExec(const SimModel& model, const ExecBlock& block) override;
+};
+
+// DVFS policy running every core at the lowest level that covers the density of the active jobs (work left over time to deadline):
+// the summed density spread over the cores, and at least the densest job on the slowest core (it may be placed there)
+// levels are ascending fractions of each core's speed from SimModel::speeds, the highest is used once a job can't make its deadline
+// densities only look at released jobs, so this lowers the speed without guaranteeing the deadlines of later ones
+struct DensityDvfsPolicy : public DvfsPolicy {
+    std::vector<Fraction> levels;
+    DensityDvfsPolicy(const std::vector<Fraction>& levels) : levels(levels) { assert(!levels.empty()); }
+    void setSpeeds(const SimModel& model, std::vector<Fraction>& speed) const override;
+};
+
+#endif
\ No newline at end of file
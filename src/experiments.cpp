@@ -4,6 +4,7 @@
 #include "model.h"
 #include "taskgen.h"
 #include "schedulers/schedulers.h"
+#include "energy.h"
 
 #include <vector>
 #include <cmath>
@@ -12,6 +13,7 @@
 #include <fstream>
 #include <deque>
 #include <string>
+#include <functional>
 
 struct SchedulerData {
     std::vector<Fraction> util_data;
@@ -29,7 +31,7 @@ public:
         std::ofstream output;
         output.open("experiment_data_kraemer.txt");
         for (int i = 0; i < TRIALS; ++i) {
-            TaskSet task_set = TaskSetGenerator::genModifiedKraemer(PRECISION, Fraction(3,2), DIM, 1, 1);
+            ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(PRECISION, Fraction(3,2), DIM, 1, 1);
             output << "(" << *(task_set[0].exec_time);
             for (int j = 1; j < DIM; ++j) {
                 output << "," << *(task_set[j].exec_time);
@@ -49,6 +51,7 @@ public:
         const int SIM_TIME = 1000;
         const int SCHED_COUNT = 5;
         const int PD2_SCALE = 10;
+        const double TRIAL_SECONDS = 30; // wall clock budget of each simulation, a trial that runs out is not counted as schedulable
 
         std::cout << "SETTING UP EXPERIMENT" << std::endl;
         Scheduler* schedulers[SCHED_COUNT];
@@ -75,12 +78,22 @@ public:
         scheduler_names[4] = "U-EDF";
         sched_check_util[4] = Fraction(1,1) * cores;
 
+        // LLREF and U-EDF need exact time, they are left out with MARISA_TICK_TIME
+        bool skipped[SCHED_COUNT] = {false, false, false, !EXACT_TIME, !EXACT_TIME};
+
         SchedulerData data[SCHED_COUNT];
         for (int i = 0; i < 4; ++i)
             data[i] = SchedulerData();
         Fraction step = Fraction(cores, UTIL_STEPS);
         SimModel model;
         model.ebs_active = false;
+        model.keep_finished_jobs = false;
+        SimLimits limits;
+        limits.max_seconds = TRIAL_SECONDS;
+        limits.progress_interval = 5;
+        limits.progress = [](const SimProgress& progress) {
+            std::cout << "  " << progress.events << " events, " << (long long)progress.eventsPerSecond() << " events/s" << std::endl;
+        };
         int max_lcm = 1;
         for (int p = MIN_PERIOD; p <= MAX_PERIOD; ++p) {
             max_lcm = std::lcm(max_lcm, p);
@@ -101,16 +114,17 @@ public:
             }
             for (int trial = 0; trial < TRIALS_PER_UTIL; ++trial) {
                 std::cout << "TRIAL " << trial << std::endl;
-                TaskSet task_set = TaskSetGenerator::genModifiedKraemer(PRECISION, util, TASK_COUNT, MIN_PERIOD, MAX_PERIOD);
+                ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(PRECISION, util, TASK_COUNT, MIN_PERIOD, MAX_PERIOD);
                 sample_points.emplace_back();
                 for (int i = 0; i < TASK_COUNT; ++i)
                     sample_points.back().push_back(*(task_set[i].exec_time / task_set[i].period));
                 long long hyperperiod = 1;
-                for (Task& task : model.task_set) {
+                for (auto& task : task_set) {
                     assert(task.period.isInt());
                     hyperperiod = std::lcm(hyperperiod, task.period.getNum());
                 }
                 for (int i = 0; i < SCHED_COUNT; ++i) {
+                    if (skipped[i]) continue;
                     std::cout << scheduler_names[i] << std::endl;
                     // init model
                     long long h = hyperperiod;
@@ -118,9 +132,9 @@ public:
                     if (i == 2) {
                         cmp_time *= PD2_SCALE;
                         // handle PD2 task set discretizing
-                        TaskSet pd2_task_set;
+                        ExactTaskSet pd2_task_set;
                         pd2_task_set.reserve(task_set.size());
-                        for (Task task : task_set) {
+                        for (auto task : task_set) {
                             task.exec_time = (task.exec_time * PD2_SCALE).ceil();
                             task.period = task.period * PD2_SCALE;
                             task.relative_deadline = task.period;
@@ -131,19 +145,30 @@ public:
                     } else model.reset(task_set, schedulers[i], cores);
                     
                     // simulate to sim time, count cswitch and mig counts of schedulable tasks
-                    model.sim(cmp_time);
+                    model.detect_steady_state = false;
+                    SimProgress progress = model.sim(cmp_time, limits);
+                    if (progress.stop == SimProgress::TIME_LIMIT) {
+                        std::cout << "TIMED OUT t=" << *model.toExact(model.origin + model.time) << std::endl;
+                        continue;
+                    }
                     if (model.missed != -1) continue;
                     long long cswitches = model.cswitch_count;
-                    long long migs = 0;
-                    for (Job& job : model.finished_jobs)
-                        migs += job.migration_count;
-                    for (Job& job : model.active_jobs)
-                        migs += job.migration_count;
+                    long long migs = model.stats.migrations;
+                    for (JobView job : model.active_jobs)
+                        migs += job.migration_count();
 
-                    // simulate to 2H to check for schedulability
+                    // simulate to 2H to check for schedulability (stops early once the schedule provably repeats)
                     if (util > sched_check_util[i]) {
-                        model.sim(h * 2);
-                        std::cout << "SCHED CHECK t=" << (2 * h) << ": " << (model.missed == -1) << std::endl;
+                        model.detect_steady_state = true;
+                        progress = model.sim(h * 2, limits);
+                        if (progress.stop == SimProgress::TIME_LIMIT) {
+                            std::cout << "SCHED CHECK TIMED OUT t=" << *model.toExact(model.origin + model.time) << std::endl;
+                            continue;
+                        }
+                        std::cout << "SCHED CHECK t=" << (2 * h) << ": " << (model.missed == -1);
+                        if (model.verdict() == SimModel::SCHEDULABLE)
+                            std::cout << " (steady at t=" << *model.toExact(model.origin + model.time) << ")";
+                        std::cout << std::endl;
                     }
                     if (model.missed != -1) continue;
                     ++schedulable_count[i];
@@ -164,6 +189,7 @@ public:
         std::ofstream output;
         output.open("experiment_data_" + std::to_string(cores) + "cores.txt");
         for (int i = 0; i < SCHED_COUNT; ++i) {
+            if (skipped[i]) continue;
             output << scheduler_names[i] << std::endl;
 
             // schedulability data
@@ -196,7 +222,211 @@ public:
         output.close();
         std::cout << "EXPERIMENT DONE" << std::endl;
     }
-public:
+
+    // soft real-time: jobs run past their deadlines, records miss ratio and tardiness up to full utilization
+    static void tardiness(int cores) {
+        const int SIM_TIME = 1000;
+        const int SCHED_COUNT = 2;
+
+        Scheduler* schedulers[SCHED_COUNT] = {new GEDF(), new GDM()};
+        SimModel model;
+        model.ebs_active = false;
+        model.keep_finished_jobs = false;
+        model.miss_policy = SimModel::CONTINUE;
+
+        sweep("tardiness", cores, cores, {"GEDF", "GDM"}, {"miss ratio", "mean tardiness", "max tardiness"}, [&](const ExactTaskSet& task_set, int trial, SweepPoint& point) {
+            for (int i = 0; i < SCHED_COUNT; ++i) {
+                model.reset(task_set, schedulers[i], cores);
+                model.sim(SIM_TIME);
+                double trial_max = 0;
+                for (const TardinessStats& task : model.task_stats) {
+                    point[i][0].add(task.misses, task.jobs);
+                    point[i][1].add(task.tardiness_sum, task.completed);
+                    trial_max = std::max(trial_max, task.tardiness_max);
+                }
+                point[i][2].add(trial_max); // reported as the mean of each trial's max
+            }
+        });
+    }
+    // soft real-time under sporadic releases and execution times below the WCET, records the miss ratio against the periodic WCET case
+    static void variation(int cores) {
+        const int SIM_TIME = 1000;
+        const int SCHED_COUNT = 2;
+
+        Scheduler* schedulers[SCHED_COUNT] = {new GEDF(), new GDM()};
+        UniformReleaseModel release_model(Fraction(1, 4), Fraction(1, 10));
+        UniformExecModel exec_model(Fraction(1, 2));
+        SimModel model;
+        model.ebs_active = false;
+        model.keep_finished_jobs = false;
+        model.miss_policy = SimModel::CONTINUE;
+
+        sweep("variation", cores, cores, {"GEDF", "GDM"}, {"periodic miss ratio", "varied miss ratio"}, [&](const ExactTaskSet& task_set, int trial, SweepPoint& point) {
+            for (int i = 0; i < SCHED_COUNT; ++i) {
+                for (int varied = 0; varied < 2; ++varied) {
+                    model.release_model = varied ? &release_model : nullptr;
+                    model.exec_model = varied ? &exec_model : nullptr;
+                    model.variation_seed = trial;
+                    model.reset(task_set, schedulers[i], cores);
+                    model.sim(SIM_TIME);
+                    for (const TardinessStats& task : model.task_stats)
+                        point[i][varied].add(task.misses, task.jobs);
+                }
+            }
+        });
+    }
+
+    // hard real-time with switching overheads, records the schedulability of GEDF and U-EDF with and without them
+    // working sets are drawn per task, so a preemption costs each task a different cache reload
+    static void overheads(int cores) {
+        const int MIN_WORKING_SET = 10;
+        const int MAX_WORKING_SET = 100;
+        const int SCHED_COUNT = EXACT_TIME ? 2 : 1; // U-EDF needs exact time, it is left out with MARISA_TICK_TIME
+        const double TRIAL_SECONDS = 30;
+
+        Scheduler* schedulers[] = {new GEDF(), new UEDF()};
+        std::vector<std::string> scheduler_names = {"GEDF", "U-EDF"};
+        scheduler_names.resize(SCHED_COUNT);
+        CacheOverheadModel overhead_model(Fraction(1, 100), Fraction(1, 50), Fraction(1, 2000));
+        std::uniform_int_distribution<int> working_set_urand(MIN_WORKING_SET, MAX_WORKING_SET);
+        SimModel model;
+        model.ebs_active = false;
+        model.keep_finished_jobs = false;
+        model.detect_steady_state = true;
+        SimLimits limits;
+        limits.max_seconds = TRIAL_SECONDS;
+
+        sweep("overheads", cores, cores, scheduler_names, {"sched", "sched with overheads"}, [&](const ExactTaskSet& task_set, int trial, SweepPoint& point) {
+            overhead_model.working_set.clear();
+            for (int i = 0; i < task_set.size(); ++i)
+                overhead_model.working_set.push_back(working_set_urand(TaskSetGenerator::gen));
+            long long hyperperiod = 1;
+            for (auto& task : task_set)
+                hyperperiod = std::lcm(hyperperiod, task.period.getNum());
+            for (int i = 0; i < SCHED_COUNT; ++i) {
+                for (int charged = 0; charged < 2; ++charged) {
+                    model.overhead_model = charged ? &overhead_model : nullptr;
+                    model.reset(task_set, schedulers[i], cores);
+
+                    // simulate to 2H (stops early once the schedule provably repeats), a trial that runs out is not counted
+                    SimProgress progress = model.sim(hyperperiod * 2, limits);
+                    point[i][charged].add(progress.stop != SimProgress::TIME_LIMIT && model.missed == -1);
+                }
+            }
+        });
+    }
+
+    // hard real-time on big.LITTLE cores (the first half at full speed, the rest slower and more frugal)
+    // records each scheduler's schedulability and mean power over its schedulable trials, at fixed speeds and under DensityDvfsPolicy
+    static void energy(int cores) {
+        const int SCHED_COUNT = 4;
+        const double TRIAL_SECONDS = 30;
+
+        // event driven schedulers only, the quantum (whole time units) and fluid (unit speed budgets) ones don't fit these cores
+        Scheduler* schedulers[SCHED_COUNT] = {new GEDF(), new GDM(), new GFIFO(), new EDZL()};
+        int big_cores = (cores + 1) / 2;
+        Fraction little_speed(1, 2);
+        PowerModel power;
+        power.static_power.assign(big_cores, 0.1);
+        power.static_power.push_back(0.02);
+        power.dynamic_power.assign(big_cores, 1);
+        power.dynamic_power.push_back(0.4);
+        power.idle_power.assign(big_cores, 0.05);
+        power.idle_power.push_back(0.01);
+        EnergyMeter meter(power);
+        DensityDvfsPolicy dvfs({Fraction(1, 4), Fraction(1, 2), Fraction(3, 4), Fraction(1)});
+        Fraction capacity = big_cores + little_speed * (cores - big_cores);
+        SimModel model;
+        model.ebs_active = false;
+        model.keep_finished_jobs = false;
+        model.detect_steady_state = true;
+        model.observers.push_back(&meter);
+        model.speeds.assign(big_cores, 1);
+        model.speeds.resize(cores, little_speed);
+        SimLimits limits;
+        limits.max_seconds = TRIAL_SECONDS;
+
+        // series 2 * scaled is the schedulability and 2 * scaled + 1 the mean power, scaled under DensityDvfsPolicy
+        sweep("energy", cores, capacity, {"GEDF", "GDM", "GFIFO", "EDZL"}, {"sched", "mean power", "sched with dvfs", "mean power with dvfs"}, [&](const ExactTaskSet& task_set, int trial, SweepPoint& point) {
+            long long hyperperiod = 1;
+            for (auto& task : task_set)
+                hyperperiod = std::lcm(hyperperiod, task.period.getNum());
+            for (int i = 0; i < SCHED_COUNT; ++i) {
+                for (int scaled = 0; scaled < 2; ++scaled) {
+                    model.dvfs_policy = scaled ? &dvfs : nullptr;
+                    model.reset(task_set, schedulers[i], cores);
+
+                    // simulate to 2H (stops early once the schedule provably repeats), a trial that runs out is not counted
+                    SimProgress progress = model.sim(hyperperiod * 2, limits);
+                    bool schedulable = progress.stop != SimProgress::TIME_LIMIT && model.missed == -1;
+                    point[i][2 * scaled].add(schedulable);
+                    if (schedulable)
+                        point[i][2 * scaled + 1].add(meter.energy(model) / meter.elapsed(model));
+                }
+            }
+        });
+    }
+private:
+    // a value averaged over the trials counted at a utilization step (0 if none were)
+    struct SweepRatio {
+        double sum = 0;
+        double count = 0;
+
+        void add(double value, double weight = 1) {
+            sum += value;
+            count += weight;
+        }
+    };
+
+    // ratios at one utilization step, by scheduler then series
+    typedef std::vector<std::vector<SweepRatio>> SweepPoint;
+
+    // utilization sweep shared by the experiments above: TRIALS_PER_UTIL random task sets at each of UTIL_STEPS steps up to capacity
+    // run_trial simulates a task set under every scheduler and adds its results to the step's point
+    // each scheduler's series is written as "name: (util,ratio)..." to experiment_data_<name>_<cores>cores.txt
+    static void sweep(const std::string& name, int cores, Fraction capacity, const std::vector<std::string>& scheduler_names, const std::vector<std::string>& series_names,
+                      const std::function<void(const ExactTaskSet& task_set, int trial, SweepPoint& point)>& run_trial) {
+        const int UTIL_STEPS = 20;
+        const int PRECISION = UTIL_STEPS * 1000;
+        const int TRIALS_PER_UTIL = 50;
+        const int TASK_COUNT = 12;
+        const int MIN_PERIOD = 4;
+        const int MAX_PERIOD = 12;
+
+        std::vector<Fraction> util_data;
+        std::vector<std::vector<std::vector<double>>> data(scheduler_names.size(), std::vector<std::vector<double>>(series_names.size()));
+
+        std::cout << "RUNNING EXPERIMENT" << std::endl;
+        Fraction step = capacity / UTIL_STEPS;
+        for (Fraction util = step; util <= capacity; util += step) {
+            std::cout << "UTIL " << *util << std::endl;
+            SweepPoint point(scheduler_names.size(), std::vector<SweepRatio>(series_names.size()));
+            for (int trial = 0; trial < TRIALS_PER_UTIL; ++trial) {
+                ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(PRECISION, util, TASK_COUNT, MIN_PERIOD, MAX_PERIOD);
+                run_trial(task_set, trial, point);
+            }
+            util_data.push_back(util);
+            for (int i = 0; i < scheduler_names.size(); ++i)
+                for (int j = 0; j < series_names.size(); ++j)
+                    data[i][j].push_back(point[i][j].count == 0 ? 0 : point[i][j].sum / point[i][j].count);
+        }
+
+        // write to file
+        std::cout << "OUTPUTING" << std::endl;
+        std::ofstream output;
+        output.open("experiment_data_" + name + "_" + std::to_string(cores) + "cores.txt");
+        for (int i = 0; i < scheduler_names.size(); ++i) {
+            output << scheduler_names[i] << std::endl;
+            for (int j = 0; j < series_names.size(); ++j) {
+                output << series_names[j] << ": ";
+                for (int k = 0; k < util_data.size(); ++k)
+                    output << "(" << *util_data[k] << "," << data[i][j][k] << ")";
+                output << std::endl;
+            }
+        }
+        output.close();
+        std::cout << "EXPERIMENT DONE" << std::endl;
+    }
 };
 
 #endif
\ No newline at end of file
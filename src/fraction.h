@@ -3,41 +3,210 @@
 
 #include <numeric>
 #include <iostream>
+#include <climits>
+#include <stdexcept>
+#if defined(_MSC_VER) && !defined(__SIZEOF_INT128__)
+#include <intrin.h>
+#endif
+
+// checked 64-bit helpers for Fraction (128-bit intermediates where available)
+namespace frac_detail {
+    [[noreturn]] inline void overflow() {
+        throw std::overflow_error("Fraction overflow");
+    }
+
+#if defined(__SIZEOF_INT128__)
+    inline bool mulOverflow(long long a, long long b, long long& out) {
+        return __builtin_mul_overflow(a, b, &out);
+    }
+
+    inline bool addOverflow(long long a, long long b, long long& out) {
+        return __builtin_add_overflow(a, b, &out);
+    }
+
+    // returns sign of a*b - c*d without overflowing
+    inline int cmpProducts(long long a, long long b, long long c, long long d) {
+        __int128 x = (__int128)a * b;
+        __int128 y = (__int128)c * d;
+        return (x > y) - (x < y);
+    }
+
+    // t = a*b + c*d divided by div = gcd(t, g) (g > 0), false if t / div doesn't fit in 64 bits
+    inline bool reduceSumOfProducts(long long a, long long b, long long c, long long d, long long g, long long& out, long long& div) {
+        __int128 t = (__int128)a * b + (__int128)c * d;
+        div = std::gcd((long long)(t % g), g);
+        t /= div;
+        out = (long long)t;
+        return t == out;
+    }
+#else
+    // signed 64x64 -> 128 multiply as (hi, lo)
+    inline void mulWide(long long a, long long b, long long& hi, unsigned long long& lo) {
+#if defined(_M_X64)
+        lo = (unsigned long long)_mul128(a, b, &hi);
+#else
+        unsigned long long ua = a < 0 ? 0ull - (unsigned long long)a : (unsigned long long)a;
+        unsigned long long ub = b < 0 ? 0ull - (unsigned long long)b : (unsigned long long)b;
+        unsigned long long a0 = ua & 0xffffffffull, a1 = ua >> 32;
+        unsigned long long b0 = ub & 0xffffffffull, b1 = ub >> 32;
+        unsigned long long p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+        unsigned long long mid = (p00 >> 32) + (p01 & 0xffffffffull) + (p10 & 0xffffffffull);
+        unsigned long long uhi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+        unsigned long long ulo = (mid << 32) | (p00 & 0xffffffffull);
+        if ((a < 0) != (b < 0)) {
+            ulo = ~ulo + 1;
+            uhi = ~uhi + (ulo == 0);
+        }
+        hi = (long long)uhi;
+        lo = ulo;
+#endif
+    }
+
+    inline bool mulOverflow(long long a, long long b, long long& out) {
+        long long hi;
+        unsigned long long lo;
+        mulWide(a, b, hi, lo);
+        out = (long long)lo;
+        return hi != (out < 0 ? -1 : 0);
+    }
+
+    inline bool addOverflow(long long a, long long b, long long& out) {
+        out = (long long)((unsigned long long)a + (unsigned long long)b);
+        return (a < 0) == (b < 0) && (out < 0) != (a < 0);
+    }
+
+    inline int cmpProducts(long long a, long long b, long long c, long long d) {
+        long long xh, yh;
+        unsigned long long xl, yl;
+        mulWide(a, b, xh, xl);
+        mulWide(c, d, yh, yl);
+        if (xh != yh) return xh < yh ? -1 : 1;
+        return (xl > yl) - (xl < yl);
+    }
+
+    // divides the unsigned 128-bit (hi, lo) by m (0 < m < 2^63) in place, returns the remainder
+    inline unsigned long long divWide(unsigned long long& hi, unsigned long long& lo, unsigned long long m) {
+        unsigned long long rem = 0, qhi = 0, qlo = 0;
+        for (int i = 127; i >= 0; --i) {
+            rem = (rem << 1) | ((i >= 64 ? hi >> (i - 64) : lo >> i) & 1);
+            if (rem < m) continue;
+            rem -= m;
+            if (i >= 64) qhi |= 1ull << (i - 64);
+            else qlo |= 1ull << i;
+        }
+        hi = qhi;
+        lo = qlo;
+        return rem;
+    }
+
+    inline bool reduceSumOfProducts(long long a, long long b, long long c, long long d, long long g, long long& out, long long& div) {
+        long long xh, yh;
+        unsigned long long xl, yl;
+        mulWide(a, b, xh, xl);
+        mulWide(c, d, yh, yl);
+        // |a*b|, |c*d| < 2^126 so the sum can't wrap
+        unsigned long long lo = xl + yl;
+        unsigned long long hi = (unsigned long long)xh + (unsigned long long)yh + (lo < xl);
+        bool negative = (long long)hi < 0;
+        if (negative) {
+            lo = ~lo + 1;
+            hi = ~hi + (lo == 0);
+        }
+        unsigned long long qhi = hi, qlo = lo;
+        div = std::gcd((long long)divWide(qhi, qlo, g), g);
+        divWide(hi, lo, div);
+        if (hi != 0 || lo > (unsigned long long)LLONG_MAX) return false;
+        out = negative ? -(long long)lo : (long long)lo;
+        return true;
+    }
+#endif
+}
 
+// exact rational number
+// results of arithmetic are only reduced once the denominator grows past NORMALIZE_LIMIT (or on overflow),
+// so num/den may share factors; getNum/getDen always return lowest terms
 class Fraction {
     long long num;
-    long long den;
+    long long den; // always positive
+
+    static constexpr long long NORMALIZE_LIMIT = 1ll << 32;
+
+    struct Raw {};
+    Fraction(long long num, long long den, Raw) : num(num), den(den) {}
+
+    // build result of an operation, reducing only if the denominator got large
+    static Fraction make(long long num, long long den) {
+        return den > NORMALIZE_LIMIT ? Fraction(num, den) : Fraction(num, den, Raw());
+    }
+
+    // lowest terms of an unreduced operand
+    static Fraction reduced(Fraction a) {
+        long long g = std::gcd(a.num, a.den);
+        return Fraction(a.num / g, a.den / g, Raw());
+    }
+
+    // operands in lowest terms give a result in lowest terms (Knuth 4.5.1), which only overflows if the exact value can't be stored
+    static Fraction addSlow(Fraction a, Fraction b) {
+        a = reduced(a);
+        b = reduced(b);
+        long long g = std::gcd(a.den, b.den);
+        long long n, div, d;
+        if (!frac_detail::reduceSumOfProducts(a.num, b.den / g, b.num, a.den / g, g, n, div)
+            || frac_detail::mulOverflow(a.den / g, b.den / div, d))
+            frac_detail::overflow();
+        return Fraction(n, d, Raw());
+    }
+
+    static Fraction mulSlow(Fraction a, Fraction b) {
+        a = reduced(a);
+        b = reduced(b);
+        long long g1 = std::gcd(a.num, b.den);
+        long long g2 = std::gcd(b.num, a.den);
+        long long n, d;
+        if (frac_detail::mulOverflow(a.num / g1, b.num / g2, n)
+            || frac_detail::mulOverflow(a.den / g2, b.den / g1, d))
+            frac_detail::overflow();
+        return Fraction(n, d, Raw());
+    }
+
+    int cmp(Fraction other) const {
+        if (den == other.den) return (num > other.num) - (num < other.num);
+        return frac_detail::cmpProducts(num, other.den, other.num, den);
+    }
 public:
-    Fraction(long long num = 0, long long den = 1) {
+    Fraction(long long num = 0, long long den = 1) : num(num), den(den) {
+        if (den == 1) return;
+        if (den == 0)
+            throw std::domain_error("Fraction with zero denominator");
         if (den < 0) {
+            if (num == LLONG_MIN || den == LLONG_MIN) frac_detail::overflow();
             num = -num;
             den = -den;
         }
         long long div = std::gcd(num, den);
-        num /= div;
-        den /= div;
-        this->num = num;
-        this->den = den;
+        this->num = num / div;
+        this->den = den / div;
     }
 
     bool isInt() const {
-        return den == 1;
+        return den == 1 || num % den == 0;
     }
 
+    // quotient rounded towards zero, corrected by the remainder's sign (never overflows)
     long long floor() const {
-        return num / den; 
+        return num / den - (num % den < 0);
     }
 
     long long ceil() const {
-        return (num + den - 1) / den;
+        return num / den + (num % den > 0);
     }
 
     long long getNum() const {
-        return num;
+        return den == 1 ? num : num / std::gcd(num, den);
     }
 
     long long getDen() const {
-        return den;
+        return den == 1 ? 1 : den / std::gcd(num, den);
     }
 
     float operator*() const {
@@ -45,15 +214,35 @@ public:
     }
 
     Fraction operator-() const {
-        return Fraction(-num, den);
+        if (num == LLONG_MIN) frac_detail::overflow();
+        return Fraction(-num, den, Raw());
     }
 
     Fraction operator!() const {
-        return Fraction(den, num);
+        if (num == 0)
+            throw std::domain_error("Fraction with zero denominator");
+        if (num == LLONG_MIN) frac_detail::overflow();
+        return num < 0 ? Fraction(-den, -num, Raw()) : Fraction(den, num, Raw());
     }
 
     Fraction operator+(Fraction other) const {
-        return Fraction(num * other.den + den * other.num, den * other.den);
+        long long n, d;
+        if (den == other.den) {
+            if (frac_detail::addOverflow(num, other.num, n)) return addSlow(*this, other);
+            return Fraction(n, den, Raw());
+        }
+        if (other.den == 1) {
+            if (frac_detail::mulOverflow(other.num, den, n) || frac_detail::addOverflow(num, n, n)) return addSlow(*this, other);
+            return Fraction(n, den, Raw());
+        }
+        if (den == 1) return other + (*this);
+        long long x, y;
+        if (frac_detail::mulOverflow(num, other.den, x)
+            || frac_detail::mulOverflow(other.num, den, y)
+            || frac_detail::addOverflow(x, y, n)
+            || frac_detail::mulOverflow(den, other.den, d))
+            return addSlow(*this, other);
+        return make(n, d);
     }
 
     Fraction operator-(Fraction other) const {
@@ -61,7 +250,11 @@ public:
     }
 
     Fraction operator*(Fraction other) const {
-        return Fraction(num * other.num, den * other.den);
+        long long n, d;
+        if (frac_detail::mulOverflow(num, other.num, n)) return mulSlow(*this, other);
+        if (den == 1 && other.den == 1) return Fraction(n, 1, Raw());
+        if (frac_detail::mulOverflow(den, other.den, d)) return mulSlow(*this, other);
+        return make(n, d);
     }
 
     Fraction operator/(Fraction other) const {
@@ -69,27 +262,27 @@ public:
     }
 
     bool operator==(Fraction other) const {
-        return num == other.num && den == other.den;
+        return cmp(other) == 0;
     }
 
     bool operator!=(Fraction other) const {
-        return !((*this) == other);
+        return cmp(other) != 0;
     }
 
     bool operator<(Fraction other) const {
-        return num * other.den < other.num * den;
+        return cmp(other) < 0;
     }
 
     bool operator<=(Fraction other) const {
-        return num * other.den <= other.num * den;
+        return cmp(other) <= 0;
     }
 
     bool operator>(Fraction other) const {
-        return num * other.den > other.num * den;
+        return cmp(other) > 0;
     }
 
     bool operator>=(Fraction other) const {
-        return num * other.den >= other.num * den;
+        return cmp(other) >= 0;
     }
 
     template<typename T>
@@ -0,0 +1,115 @@
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <vector>
+#include <utility>
+#include <cassert>
+
+// binary min-heap of keys addressed by integer id, supporting key updates and removal by id
+// equal keys are ordered by id
+template<class K>
+class IndexedHeap {
+    std::vector<std::pair<K,int>> heap; // (key, id)
+    std::vector<int> pos; // pos[id] = index of id in heap (-1 if absent)
+
+    static bool less(const std::pair<K,int>& a, const std::pair<K,int>& b) {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    }
+
+    void place(int i, std::pair<K,int> entry) {
+        heap[i] = entry;
+        pos[entry.second] = i;
+    }
+
+    void siftUp(int i) {
+        std::pair<K,int> entry = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) >> 1;
+            if (!less(entry, heap[parent])) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+
+    void siftDown(int i) {
+        std::pair<K,int> entry = heap[i];
+        int n = heap.size();
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && less(heap[child + 1], heap[child])) ++child;
+            if (!less(heap[child], entry)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, entry);
+    }
+public:
+    bool empty() const {
+        return heap.empty();
+    }
+
+    int size() const {
+        return heap.size();
+    }
+
+    bool contains(int id) const {
+        return id < pos.size() && pos[id] != -1;
+    }
+
+    // smallest key (heap must not be empty)
+    const K& top() const {
+        return heap.front().first;
+    }
+
+    // id with the smallest key (heap must not be empty)
+    int topId() const {
+        return heap.front().second;
+    }
+
+    const K& get(int id) const {
+        return heap[pos[id]].first;
+    }
+
+    // insert id or change its key
+    void set(int id, K key) {
+        if (id >= pos.size())
+            pos.resize(id + 1, -1);
+        int i = pos[id];
+        if (i == -1) {
+            heap.emplace_back(key, id);
+            siftUp(heap.size() - 1);
+        } else {
+            heap[i].first = key;
+            siftUp(i);
+            siftDown(pos[id]);
+        }
+    }
+
+    // remove id if present
+    void erase(int id) {
+        if (!contains(id)) return;
+        int i = pos[id];
+        pos[id] = -1;
+        std::pair<K,int> last = heap.back();
+        heap.pop_back();
+        if (i == heap.size()) return;
+        place(i, last);
+        siftUp(i);
+        siftDown(pos[last.second]);
+    }
+
+    void clear() {
+        heap.clear();
+        pos.clear();
+    }
+
+    // subtract delta from every key (order is unchanged)
+    void shift(K delta) {
+        for (auto& entry : heap)
+            entry.first -= delta;
+    }
+};
+
+#endif
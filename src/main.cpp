@@ -2,36 +2,64 @@
 #include "view.h"
 #include "schedulers/schedulers.h"
 #include "taskgen.h"
+#include "trace.h"
 #include "experiments.cpp"
 #include <iostream>
 #include <cmath>
 #include <deque>
 #include <algorithm>
 
-int main() {
+int main(int argc, char** argv) {
     /*
     Experiment::kraemer();
     Experiment::sched(2);
     Experiment::sched(4);
     Experiment::sched(8);
+    Experiment::tardiness(4);
+    Experiment::variation(4);
+    Experiment::overheads(4);
+    Experiment::energy(4);
     return 0;
     */
 
+    // convert a recorded trace to Chrome trace event JSON: <trace> <json>
+    if (argc > 2) {
+        TraceFile trace;
+        if (!trace.open(argv[1])) {
+            std::cout << "failed to open trace " << argv[1] << std::endl;
+            return 1;
+        }
+        std::ofstream out(argv[2]);
+        TraceReader reader = trace.reader();
+        exportChromeTrace(reader, out);
+        return 0;
+    }
+
     Visualizer::init();
     SimModel model;
     // setup test model
-    Scheduler* scheduler = new UEDF();
-    TaskSet task_set = TaskSetGenerator::genModifiedKraemer(10, 4, 12, 4, 12);
+    Scheduler* scheduler = EXACT_TIME ? (Scheduler*)new UEDF() : new GEDF(); // U-EDF needs exact time
+    ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(10, 4, 12, 4, 12);
     model.reset(task_set, scheduler, 4);
 
+    // replay a recorded trace instead if one is given
+    TraceFile trace;
+    bool replaying = argc > 1 && trace.open(argv[1]) && !trace.runs.empty();
+    if (argc > 1 && !replaying)
+        std::cout << "failed to open trace " << argv[1] << std::endl;
+
     Visualizer view;
     view.tf = Transform::scale(START_ZOOM) * Transform::id();
     const float init_scale = 0.8f;
     view.open(sf::VideoMode::getDesktopMode().width * init_scale, sf::VideoMode::getDesktopMode().height * init_scale);
+    if (replaying)
+        view.replay(trace, 0);
     MouseState mouse;
     mouse.mouse_down = false;
     mouse.mouse_lost = true;
     sf::Clock clock;
+    SimLimits frame_limits;
+    frame_limits.max_seconds = 0.008;
     std::deque<long long> frame_time_history;
     long long frame_time_sum = 0.f;
     bool left_pressed = false;
@@ -136,12 +164,17 @@ int main() {
         if (KeyState::keyPressed(sf::Keyboard::X))
             std::cout << model.cswitch_count << std::endl;
 
-        // calc step - update model
-        int end_time = (int)std::ceil((view.tf.inv() * Pos(view.window.getSize())).x);
-        model.sim(end_time);
+        // calc step - update model (a bounded slice per frame, the rest follows on later frames)
+        if (!replaying) {
+            int end_time = (int)std::ceil((view.tf.inv() * Pos(view.window.getSize())).x);
+            model.sim(end_time, frame_limits);
+        }
 
         // draw step - update view
-        view.update(model, mouse, fps);
+        if (replaying)
+            view.update(mouse, fps);
+        else
+            view.update(model, mouse, fps);
 
         // timing analysis
         long long frame_time = clock.getElapsedTime().asMicroseconds();
@@ -1,136 +1,655 @@
 #include "model.h"
+#include "sim_loop.h"
 #include <cassert>
 #include <climits>
 #include <iostream>
 #include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <typeinfo>
+#include <type_traits>
 
-Job Task::next_job(int task_id) {
-    Job job(this, task_id, next_job_id++, next_release, exec_time, next_release + relative_deadline);
+template<class T>
+BasicJob<T> BasicTask<T>::next_job(int task_id) {
+    BasicJob<T> job(this, task_id, next_job_id++, next_release, exec_time, next_release + relative_deadline);
     next_release += period;
     return job;
 }
 
+template struct BasicTask<Time>;
+
 void Scheduler::init(const TaskSet& task_set, int cores) {}
 
-ScheduleDecision Scheduler::schedule(const SimModel& model) {
-    return ScheduleDecision(model.cores);
+void Scheduler::schedule(const SimModel& model, ScheduleDecision& sd) {}
+
+void Scheduler::rebase(Time shift) {}
+
+void Scheduler::fingerprint(const SimModel& model, std::vector<Time>& state) const {}
+
+bool Scheduler::incremental() const {
+    return false;
 }
 
-void ExecBlockStorage::add_block(const Job& job, Fraction start, Fraction end) {
-    new_blocks.emplace_back(job.task_id, job.job_id, job.core, start, end,
-        job.runtime >= job.exec_time ? ExecBlock::COMPLETED : job.deadline <= end ? ExecBlock::MISSED : ExecBlock::PREEMPTED
-    );
+void Scheduler::on_release(const SimModel& model, int slot, ScheduleDelta& delta) {}
+
+void Scheduler::on_complete(const SimModel& model, int slot, ScheduleDelta& delta) {}
+
+void Scheduler::on_deadline(const SimModel& model, int slot, ScheduleDelta& delta) {}
+
+void Scheduler::on_timer(const SimModel& model, int id, ScheduleDelta& delta) {}
+
+bool Scheduler::sameDecision(const SimModel& model, const CoreState& a, const CoreState& b) const {
+    CoreState sorted_a = a;
+    CoreState sorted_b = b;
+    std::sort(sorted_a.begin(), sorted_a.end());
+    std::sort(sorted_b.begin(), sorted_b.end());
+    return sorted_a == sorted_b;
 }
 
-void ExecBlockStorage::clear() {
-    exec_blocks.clear();
-    new_blocks.clear();
+std::shared_ptr<const Scheduler> Scheduler::clone_state() const {
+    return nullptr;
 }
 
-bool ExecBlockStorage::hasNext() {
-    return !new_blocks.empty();
+void Scheduler::restore_state(const Scheduler& state) {}
+
+Time ReleaseModel::slack(const Task& task, int task_id, std::mt19937_64& rng) const {
+    return 0;
 }
 
-ExecBlock ExecBlockStorage::getNext() {
-    ExecBlock block = new_blocks.front();
-    new_blocks.pop_front();
-    exec_blocks.push_back(block);
-    return block;
+Time ReleaseModel::jitter(const Task& task, int task_id, std::mt19937_64& rng) const {
+    return 0;
 }
 
-void SimModel::sim(Fraction endTime) {
-    CoreState core_state(cores, -1);
-    for (int i = 0; i < active_jobs.size(); ++i)
-        if (active_jobs[i].running)
-            core_state[active_jobs[i].core] = i;
-    std::vector<bool> was_running;
-    std::vector<std::pair<Fraction,int>> next_release;
-    next_release.reserve(task_set.size());
-    for (int i = 0; i < task_set.size(); ++i)
-        next_release.emplace_back(task_set[i].next_release, i);
-    auto heap_cmp = [](std::pair<Fraction, int>& a, std::pair<Fraction, int>& b) {
-        return a.first > b.first;
+Time ExecModel::execTime(const Task& task, int task_id, std::mt19937_64& rng) const {
+    return task.exec_time;
+}
+
+Time OverheadModel::switchCost(const SimModel& model, JobView job, int core) const {
+    return 0;
+}
+
+void DvfsPolicy::setSpeeds(const SimModel& model, std::vector<Fraction>& speed) const {}
+
+Time scaleTime(Time t, Fraction ratio) {
+#ifdef MARISA_TICK_TIME
+    return (Fraction(t) * ratio).floor();
+#else
+    return t * ratio;
+#endif
+}
+
+Time hyperperiod(const TaskSet& task_set) {
+    if (task_set.empty()) return 0;
+
+    // lcm of fractions = lcm of numerators / gcd of denominators
+    long long num = 1;
+    long long den = 0;
+    for (const Task& task : task_set) {
+        Fraction period = task.period;
+        long long n = period.getNum() / std::gcd(num, period.getNum());
+        if (n != 0 && num > LLONG_MAX / n)
+            return 0;
+        num *= n;
+        den = std::gcd(den, period.getDen());
+    }
+#ifdef MARISA_TICK_TIME
+    return num;
+#else
+    return Fraction(num, den);
+#endif
+}
+
+long long denominatorLcm(const ExactTaskSet& task_set) {
+    long long time_scale = 1;
+    auto scale_by = [&time_scale](Fraction value) {
+        long long den = value.getDen();
+        long long scale = time_scale / std::gcd(time_scale, den);
+        if (scale > LLONG_MAX / den)
+            throw std::overflow_error("task set denominator lcm overflow");
+        time_scale = scale * den;
     };
-    std::make_heap(next_release.begin(), next_release.end(), heap_cmp);
-    int cycles = 0;
-    while (missed == -1 && time < endTime) {
-        // handle job releases by time
-        while (next_release.front().first <= time) {
-            std::pop_heap(next_release.begin(), next_release.end(), heap_cmp);
-            int tid = next_release.back().second;
-            active_jobs.push_back(task_set[tid].next_job(tid));
-            next_release.back().first = task_set[tid].next_release;
-            std::push_heap(next_release.begin(), next_release.end(), heap_cmp);
-        }
+    for (const auto& task : task_set) {
+        scale_by(task.phase);
+        scale_by(task.period);
+        scale_by(task.exec_time);
+        scale_by(task.relative_deadline);
+    }
+    return time_scale;
+}
 
-        // sort jobs by executing first then preemptive then fresh
-        int next_executing = 0;
-        int next_preempted = 0;
-        int next_unexecuted = 0;
-        for (Job& job : active_jobs) {
-            if (job.running) ++next_preempted;
-            else if (job.core != -1) ++next_unexecuted;
-        }
-        next_unexecuted += next_preempted;
-        JobSet sorted_jobs(active_jobs.size());
-        for (Job& job : active_jobs) {
-            if (job.running) sorted_jobs[next_executing++] = std::move(job);
-            else if (job.core != -1) sorted_jobs[next_preempted++] = std::move(job);
-            else sorted_jobs[next_unexecuted++] = std::move(job);
-        }
-        swap(sorted_jobs, active_jobs);
-
-        // schedule
-        ScheduleDecision sd = scheduler->schedule(*this);
-        assert(sd.core_state.size() == cores);
-        was_running.resize(active_jobs.size());
-        for (int i = 0; i < active_jobs.size(); ++i) {
-            was_running[i] = active_jobs[i].running;
-            active_jobs[i].running = false;
-        }
-        for (int i = 0; i < sd.core_state.size(); ++i) {
-            cswitch_count += core_state[i] != sd.core_state[i];
-            Job& job = active_jobs[sd.core_state[i]];
-            if (sd.core_state[i] != -1) {
-                if (job.core != -1 && job.core != i) ++job.migration_count;
-                job.core = i;
-                job.running = true;
-            }
-        }
-        Fraction delta_time = sd.next_event - time;
-        assert(delta_time > 0);
-
-        // update exec blocks and buffer + handle job deadlines (and misses) + handle preemption counting
-        int j = -1;
-        for (int i = 0; i < active_jobs.size(); ++i) {
-            Job& job = active_jobs[i];
-            if (job.running) {
-                Fraction block_runtime = std::min(job.exec_time - job.runtime, delta_time);
-                job.runtime += block_runtime;
-                if (ebs_active)
-                    ebs.add_block(job, time, time + block_runtime);
-                if (job.runtime == job.exec_time) {
-                    finished_jobs.push_back(job);
-                    continue;
-                } else job.preempt_count += !was_running[i];
-            }
-            if (job.deadline <= sd.next_event)
-                missed = i;
-            active_jobs[++j] = job;
+long long tickScale(const ExactTaskSet& task_set) {
+#ifdef MARISA_TICK_TIME
+    return denominatorLcm(task_set);
+#else
+    return 1;
+#endif
+}
+
+Time toTime(Fraction t, long long time_scale) {
+#ifdef MARISA_TICK_TIME
+    return (t * time_scale).ceil();
+#else
+    return t;
+#endif
+}
+
+// write value into row slot, growing the column when slot is new
+template<class V, class X>
+static void setColumn(V& column, int slot, const X& value) {
+    if (slot == column.size()) column.push_back(value);
+    else column[slot] = value;
+}
+
+int JobSet::add(const Job& job) {
+    int slot = slots();
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    setColumn(uid, slot, job.uid);
+    setColumn(task_id, slot, job.task_id);
+    setColumn(job_id, slot, job.job_id);
+    setColumn(release_time, slot, job.release_time);
+    setColumn(exec_time, slot, job.exec_time);
+    setColumn(work, slot, job.work);
+    setColumn(deadline, slot, job.deadline);
+    setColumn(runtime, slot, job.runtime);
+    setColumn(overhead, slot, job.overhead);
+    setColumn(preempt_count, slot, job.preempt_count);
+    setColumn(migration_count, slot, job.migration_count);
+    setColumn(source_task, slot, job.source_task);
+    setColumn(core, slot, job.core);
+    setColumn(running, slot, job.running);
+    setColumn(event_id, slot, job.event_id);
+    if (slot == gen.size()) gen.push_back(0);
+    order.push_back(slot);
+    return slot;
+}
+
+void JobSet::remove(int slot) {
+    ++gen[slot];
+    deadline[slot] = TIME_MAX;
+    running[slot] = false;
+    free_slots.push_back(slot);
+}
+
+Job JobSet::get(int slot) const {
+    Job job(source_task[slot], task_id[slot], job_id[slot], release_time[slot], exec_time[slot], deadline[slot]);
+    job.work = work[slot];
+    job.runtime = runtime[slot];
+    job.overhead = overhead[slot];
+    job.preempt_count = preempt_count[slot];
+    job.migration_count = migration_count[slot];
+    job.core = core[slot];
+    job.running = running[slot];
+    job.event_id = event_id[slot];
+    return job;
+}
+
+void JobSet::clear() {
+    forEachColumn([](auto& column) {
+        column.clear();
+    });
+    order.clear();
+    free_slots.clear();
+}
+
+void EventQueue::reset(const TaskSet& task_set) {
+    releases.clear();
+    deadlines.clear();
+    timers.clear();
+    free_deadline_ids.clear();
+    deadline_id_count = 0;
+    for (int i = 0; i < task_set.size(); ++i)
+        releases.set(i, task_set[i].next_release);
+}
+
+void EventQueue::setRelease(int task_id, Time time) {
+    releases.set(task_id, time);
+}
+
+int EventQueue::addDeadline(Time deadline) {
+    int id;
+    if (free_deadline_ids.empty()) {
+        id = deadline_id_count++;
+    } else {
+        id = free_deadline_ids.back();
+        free_deadline_ids.pop_back();
+    }
+    deadlines.set(id, deadline);
+    return id;
+}
+
+void EventQueue::removeDeadline(int id) {
+    deadlines.erase(id);
+    free_deadline_ids.push_back(id);
+}
+
+void EventQueue::setTimer(int id, Time time) {
+    timers.set(id, time);
+}
+
+void EventQueue::clearTimer(int id) {
+    timers.erase(id);
+}
+
+int EventQueue::nextReleaseTask() const {
+    return releases.topId();
+}
+
+int EventQueue::nextTimerId() const {
+    return timers.topId();
+}
+
+Time EventQueue::nextRelease() const {
+    return releases.empty() ? TIME_MAX : releases.top();
+}
+
+Time EventQueue::nextDeadline() const {
+    return deadlines.empty() ? TIME_MAX : deadlines.top();
+}
+
+Time EventQueue::nextTimer() const {
+    return timers.empty() ? TIME_MAX : timers.top();
+}
+
+void EventQueue::shift(Time shift) {
+    releases.shift(shift);
+    deadlines.shift(shift);
+    timers.shift(shift);
+}
+
+static_assert(std::is_trivially_copyable<ExecBlock>::value, "exec blocks are spilled as raw bytes");
+
+void ExecBlockStorage::evict() {
+    size_t chunk_end = (first / CHUNK_SIZE + 1) * CHUNK_SIZE;
+    if (overflow == SPILL) {
+        spill.seekp((first - spill_begin) * sizeof(ExecBlock));
+        spill.write((const char*)&at(first), (chunk_end - first) * sizeof(ExecBlock));
+    } else {
+        dropped += chunk_end - first;
+        read = chunk_end;
+    }
+    first = chunk_end;
+}
+
+void ExecBlockStorage::resetSpill() {
+    spill.close();
+    spill.open(spill_path, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+    spill_begin = first;
+}
+
+bool ExecBlockStorage::setOverflow(Overflow overflow, const std::string& spill_path) {
+    this->overflow = overflow;
+    this->spill_path = spill_path;
+    spill.close();
+    clear();
+    if (overflow == SPILL && !spill.is_open()) {
+        this->overflow = DROP_OLDEST;
+        return false;
+    }
+    return true;
+}
+
+ExecBlock::ExecBlock(JobView job, Time start, Time end, Time origin) : ExecBlock(job.task_id(), job.job_id(), job.core(), origin + start, origin + end,
+    job.runtime() >= job.jobs->work[job.slot] ? COMPLETED : start < job.deadline() && job.deadline() <= end ? MISSED : PREEMPTED
+) {}
+
+void ExecBlockStorage::add_block(const ExecBlock& block) {
+    if (next > first && next > sealed) {
+        ExecBlock& last = at(next - 1);
+        // runs continue preempted runs, overhead continues overhead
+        bool continues = block.endState == ExecBlock::OVERHEAD ? last.endState == ExecBlock::OVERHEAD : last.endState == ExecBlock::PREEMPTED;
+        if (last.end == block.start && continues && last.task_id == block.task_id && last.job_id == block.job_id && last.core == block.core) {
+            last.end = block.end;
+            last.endState = block.endState;
+            return;
         }
-        active_jobs.resize(j+1);
-        time = sd.next_event;
     }
+    if (next - first == chunks.size() * CHUNK_SIZE)
+        evict();
+    std::vector<ExecBlock>& chunk = chunks[next / CHUNK_SIZE % chunks.size()];
+    if (chunk.empty())
+        chunk.resize(CHUNK_SIZE);
+    chunk[next % CHUNK_SIZE] = block;
+    ++next;
+}
+
+void ExecBlockStorage::clear() {
+    first = next = read = sealed = 0;
+    dropped = 0;
+    if (overflow == SPILL)
+        resetSpill();
+}
+
+bool ExecBlockStorage::hasNext() const {
+    return read < next;
+}
+
+size_t ExecBlockStorage::drain(ExecBlock* out, size_t max) {
+    size_t count = 0;
+    if (read < first) {
+        count = std::min(max, first - read);
+        spill.seekg((read - spill_begin) * sizeof(ExecBlock));
+        spill.read((char*)out, count * sizeof(ExecBlock));
+        read += count;
+        if (read == first)
+            resetSpill();
+    }
+    while (count < max && read == first && first < next) {
+        size_t chunk_end = (first / CHUNK_SIZE + 1) * CHUNK_SIZE;
+        size_t run = std::min(max - count, std::min(next, chunk_end) - first);
+        std::copy_n(&at(first), run, out + count);
+        read = first += run;
+        count += run;
+    }
+    return count;
+}
+
+size_t ExecBlockStorage::size() const {
+    return next;
+}
+
+void ExecBlockStorage::seal() const {
+    sealed = next;
+}
+
+void ExecBlockStorage::truncate(size_t count) {
+    if (count >= next) return;
+    next = count;
+    sealed = std::min(sealed, next);
+    first = std::min(first, next);
+    if (read >= first) {
+        read = first;
+        if (overflow == SPILL)
+            resetSpill();
+    }
+}
+
+void JobStats::add(const Job& job, double response_time) {
+    ++count;
+    migrations += job.migration_count;
+    preemptions += job.preempt_count;
+    double delta = response_time - response_mean;
+    response_mean += delta / count;
+    response_m2 += delta * (response_time - response_mean);
+    response_max = std::max(response_max, response_time);
+}
+
+double JobStats::responseVariance() const {
+    return count < 2 ? 0 : response_m2 / (count - 1);
+}
+
+void TardinessStats::miss() {
+    ++jobs;
+    ++misses;
+}
+
+void TardinessStats::complete(double lateness) {
+    jobs += lateness <= 0;
+    ++completed;
+    tardiness_sum += std::max(0.0, lateness);
+    tardiness_max = std::max(tardiness_max, lateness);
+    lateness_max = std::max(lateness_max, lateness);
+}
+
+void TardinessStats::drop() {
+    ++dropped;
+}
+
+double TardinessStats::missRatio() const {
+    return jobs == 0 ? 0 : (double)misses / jobs;
+}
+
+double TardinessStats::tardinessMean() const {
+    return completed == 0 ? 0 : tardiness_sum / completed;
+}
+
+SimProgress SimModel::sim(Fraction endTime, const SimLimits& limits) {
+    Time end_time = toTime(endTime);
+    return run_until([end_time](const SimModel& model) { return model.origin + model.time >= end_time; }, limits);
 }
 
-void SimModel::reset(TaskSet task_set, Scheduler* scheduler, int cores) {
-    this->task_set = task_set;
+SimProgress SimModel::run_until(const std::function<bool(const SimModel&)>& done, const SimLimits& limits) {
+    if (observers.empty())
+        return run_observed(done, limits);
+    RuntimeObservers runtime(observers);
+    return run_observed(done, limits, runtime);
+}
+
+bool SimModel::halted() const {
+    return (missed != -1 && miss_policy == ABORT) || steady_period != 0;
+}
+
+long long SimModel::step(long long max_events) {
+    SimLimits limits;
+    limits.max_events = max_events;
+    return run_until([](const SimModel& model) { return false; }, limits).events;
+}
+
+void SimModel::apply(const ScheduleDelta& delta) {
+    for (const CoreChange& change : delta)
+        core_state[change.core] = change.slot;
+}
+
+void SimModel::reset(const ExactTaskSet& task_set, Scheduler* scheduler, int cores) {
+    time_scale = tickScale(task_set);
+#ifdef MARISA_TICK_TIME
+    speed_grid = 1;
+#else
+    speed_grid = speeds.empty() && !dvfs_policy ? 1 : denominatorLcm(task_set);
+#endif
+    this->task_set.clear();
+    this->task_set.reserve(task_set.size());
+    for (const auto& task : task_set)
+        this->task_set.emplace_back(toTime(task.phase), toTime(task.period), toTime(task.exec_time), toTime(task.relative_deadline));
+    events.reset(this->task_set);
+    std::seed_seq release_seed{(unsigned)variation_seed, (unsigned)(variation_seed >> 32), 0u};
+    std::seed_seq exec_seed{(unsigned)variation_seed, (unsigned)(variation_seed >> 32), 1u};
+    release_rng.seed(release_seed);
+    exec_rng.seed(exec_seed);
+    if (release_model)
+        for (int i = 0; i < this->task_set.size(); ++i)
+            events.setRelease(i, this->task_set[i].next_release + release_model->jitter(this->task_set[i], i, release_rng));
     this->scheduler = scheduler;
-    scheduler->init(task_set, cores);
+    scheduler->events = &events;
+    scheduler->init(this->task_set, cores);
     this->cores = cores;
     time = 0;
+    origin = 0;
+    rebase_period = hyperperiod(this->task_set);
     missed = -1;
     cswitch_count = 0;
+    event_count = 0;
+    core_state.assign(cores, -1);
+    core_speed.assign(cores, 1);
+    for (int c = 0; c < cores && c < speeds.size(); ++c) {
+        assert(speeds[c] > 0);
+        core_speed[c] = speeds[c];
+    }
     active_jobs.clear();
+    stats = JobStats();
+    task_stats.assign(task_set.size(), TardinessStats());
     finished_jobs.clear();
+    steady_period = 0;
+    next_fingerprint = 0;
+    idle_fingerprinted = false;
+    fingerprints.reset();
+    for (SimObserver* observer : observers)
+        observer->onReset(*this, task_set);
+}
+
+void SimModel::fork(const SimModel& parent, Scheduler* scheduler) {
+    task_set = parent.task_set;
+    active_jobs = parent.active_jobs;
+    for (int i : active_jobs.order)
+        active_jobs.source_task[i] = &task_set[active_jobs.task_id[i]];
+    events = parent.events;
+    this->scheduler = scheduler;
+    scheduler->events = &events;
+    scheduler->init(task_set, parent.cores);
+    bool same_type = typeid(*scheduler) == typeid(*parent.scheduler);
+    if (same_type)
+        scheduler->restore_state(*parent.scheduler);
+    cores = parent.cores;
+    time_scale = parent.time_scale;
+    speed_grid = parent.speed_grid;
+    time = parent.time;
+    origin = parent.origin;
+    rebase_period = parent.rebase_period;
+    missed = parent.missed;
+    cswitch_count = parent.cswitch_count;
+    event_count = parent.event_count;
+    core_state = parent.core_state;
+    core_speed = parent.core_speed;
+    stats = parent.stats;
+    task_stats = parent.task_stats;
+    release_model = parent.release_model;
+    exec_model = parent.exec_model;
+    overhead_model = parent.overhead_model;
+    speeds = parent.speeds;
+    dvfs_policy = parent.dvfs_policy;
+    variation_seed = parent.variation_seed;
+    release_rng = parent.release_rng;
+    exec_rng = parent.exec_rng;
+    finished_jobs.clear();
+    ebs.clear();
+    steady_period = parent.steady_period;
+    next_fingerprint = parent.next_fingerprint;
+    idle_fingerprinted = parent.idle_fingerprinted;
+    fingerprints = parent.fingerprints;
+
+    // a fresh incremental scheduler learns the active jobs as if they were just released
+    if (!same_type && use_incremental && scheduler->incremental()) {
+        core_state.assign(cores, -1);
+        for (int i : active_jobs.order) {
+            delta.clear();
+            scheduler->on_release(*this, i, delta);
+            apply(delta);
+        }
+    }
+}
+
+SimSnapshot SimModel::snapshot() const {
+    SimSnapshot snapshot;
+    snapshot.task_set = std::make_shared<const TaskSet>(task_set);
+    snapshot.active_jobs = std::make_shared<const JobSet>(active_jobs);
+    snapshot.events = std::make_shared<const EventQueue>(events);
+    snapshot.scheduler_state = scheduler->clone_state();
+    snapshot.fingerprints = fingerprints;
+    snapshot.core_state = core_state;
+    snapshot.core_speed = core_speed;
+    snapshot.stats = stats;
+    snapshot.task_stats = task_stats;
+    snapshot.release_rng = release_rng;
+    snapshot.exec_rng = exec_rng;
+    snapshot.time = time;
+    snapshot.origin = origin;
+    snapshot.rebase_period = rebase_period;
+    snapshot.steady_period = steady_period;
+    snapshot.next_fingerprint = next_fingerprint;
+    snapshot.idle_fingerprinted = idle_fingerprinted;
+    snapshot.missed = missed;
+    snapshot.cswitch_count = cswitch_count;
+    snapshot.event_count = event_count;
+    snapshot.finished_count = finished_jobs.size();
+    ebs.seal();
+    snapshot.block_count = ebs.size();
+    return snapshot;
+}
+
+void SimModel::restore(const SimSnapshot& snapshot) {
+    assert(snapshot.task_set->size() == task_set.size());
+    task_set = *snapshot.task_set;
+    active_jobs = *snapshot.active_jobs;
+    for (int i : active_jobs.order)
+        active_jobs.source_task[i] = &task_set[active_jobs.task_id[i]];
+    events = *snapshot.events;
+    if (snapshot.scheduler_state)
+        scheduler->restore_state(*snapshot.scheduler_state);
+    fingerprints = snapshot.fingerprints;
+    core_state = snapshot.core_state;
+    core_speed = snapshot.core_speed;
+    stats = snapshot.stats;
+    task_stats = snapshot.task_stats;
+    release_rng = snapshot.release_rng;
+    exec_rng = snapshot.exec_rng;
+    time = snapshot.time;
+    origin = snapshot.origin;
+    rebase_period = snapshot.rebase_period;
+    steady_period = snapshot.steady_period;
+    next_fingerprint = snapshot.next_fingerprint;
+    idle_fingerprinted = snapshot.idle_fingerprinted;
+    missed = snapshot.missed;
+    cswitch_count = snapshot.cswitch_count;
+    event_count = snapshot.event_count;
+    if (snapshot.finished_count < finished_jobs.size())
+        finished_jobs.resize(snapshot.finished_count);
+    ebs.truncate(snapshot.block_count);
+}
+
+void SimModel::rebase(Time shift) {
+    origin += shift;
+    time -= shift;
+    for (Task& task : task_set)
+        task.next_release -= shift;
+    for (int i : active_jobs.order) {
+        active_jobs.release_time[i] -= shift;
+        active_jobs.deadline[i] -= shift;
+    }
+    if (next_fingerprint != TIME_MAX)
+        next_fingerprint -= shift;
+    events.shift(shift);
+    scheduler->rebase(shift);
+}
+
+SimModel::Verdict SimModel::verdict() const {
+    if (missed != -1) return UNSCHEDULABLE;
+    return steady_period > 0 ? SCHEDULABLE : UNKNOWN;
+}
+
+void SimModel::fingerprint(std::vector<Time>& state) const {
+    for (const Task& task : task_set)
+        state.push_back(task.next_release - time);
+    for (JobView job : active_jobs) {
+        state.push_back(job.task_id());
+        state.push_back(job.release_time() - time);
+        state.push_back(job.deadline() - time);
+        state.push_back(job.exec_time());
+        state.push_back(job.runtime());
+        state.push_back(job.overhead());
+        state.push_back(job.core());
+        state.push_back(job.running());
+    }
+    for (Fraction speed : core_speed) {
+        state.push_back(speed.getNum());
+        state.push_back(speed.getDen());
+    }
+    scheduler->fingerprint(*this, state);
+}
+
+Time SimModel::toTime(Fraction t) const {
+    return ::toTime(t, time_scale);
+}
+
+Fraction SimModel::toExact(Time t) const {
+    return Fraction(t) / time_scale;
+}
+
+Time SimModel::workIn(Time duration, Fraction speed) const {
+    if (speed == 1) return duration;
+#ifdef MARISA_TICK_TIME
+    return scaleTime(duration, speed);
+#else
+    return Fraction((duration * speed * speed_grid).floor(), speed_grid);
+#endif
+}
+
+Time SimModel::timeFor(Time work, Fraction speed) const {
+    if (speed == 1) return work;
+#ifdef MARISA_TICK_TIME
+    return (Fraction(work) / speed).ceil();
+#else
+    return Fraction((work / speed * speed_grid).ceil(), speed_grid);
+#endif
 }
\ No newline at end of file
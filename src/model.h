@@ -2,79 +2,363 @@
 #define MODEL_H
 
 #include "fraction.h"
+#include "indexed_heap.h"
 #include <vector>
 #include <memory>
-#include <deque>
+#include <memory_resource>
+#include <functional>
+#include <atomic>
+#include <string>
+#include <fstream>
+#include <cassert>
+#include <map>
 #include <climits>
+#include <limits>
+#include <random>
+
+// time representation used by the simulator, chosen at compile time
+// with MARISA_TICK_TIME every time value is an integer number of ticks (see SimModel::reset)
+// otherwise time is kept as exact fractions
+#ifdef MARISA_TICK_TIME
+typedef long long Time;
+inline const Time TIME_MAX = LLONG_MAX >> 2;
+constexpr bool EXACT_TIME = false;
+#else
+typedef Fraction Time;
+inline const Time TIME_MAX = INT_MAX;
+constexpr bool EXACT_TIME = true;
+#endif
+
+inline float toFloat(Fraction t) { return *t; }
+inline float toFloat(long long t) { return (float)t; }
+inline long long toInt(Fraction t) { return t.getNum(); } // only valid for integral values
+inline long long toInt(long long t) { return t; }
+inline bool isInt(Fraction t) { return t.isInt(); }
+inline bool isInt(long long t) { return true; }
+inline long long floorDiv(Fraction a, Fraction b) { return (a / b).floor(); }
+inline long long floorDiv(long long a, long long b) { return a / b; }
 
 struct SimModel;
-struct Task;
+template<class T> struct BasicTask;
 
-struct Job {
+template<class T>
+struct BasicJob {
     long long uid;
     int task_id;
     int job_id;
-    Fraction release_time, exec_time, deadline; // basic job/task stats
+    T release_time, exec_time, deadline; // basic job/task stats
+    T work; // execution time the job actually needs (exec_time unless SimModel has an ExecModel), hidden from schedulers
     int preempt_count = 0;
     int migration_count = 0;
-    const Task* source_task; // source task pointer
-    Fraction runtime = 0; // time job has executed for
+    const BasicTask<T>* source_task; // source task pointer
+    T runtime = 0; // time job has executed for
+    T overhead = 0; // switching overhead left before the job makes progress on its core (see OverheadModel)
     int core = -1; // core the job was last on (or currently on if running) (-1 if not executed yet)
     bool running = false; // true if the job is currently running
-    Job(const Task* source_task = nullptr, int task_id = -1, int job_id = -1, Fraction release_time = 0, Fraction exec_time = 0, Fraction deadline = 0) : source_task(source_task), uid((((long long)task_id) << 32) | job_id), task_id(task_id), job_id(job_id), release_time(release_time), exec_time(exec_time), deadline(deadline) {}
+    int event_id = -1; // id of this job's deadline in the model's EventQueue (-1 once the deadline passed with SimModel::CONTINUE)
+    BasicJob(const BasicTask<T>* source_task = nullptr, int task_id = -1, int job_id = -1, T release_time = 0, T exec_time = 0, T deadline = 0) : source_task(source_task), uid((((long long)task_id) << 32) | job_id), task_id(task_id), job_id(job_id), release_time(release_time), exec_time(exec_time), deadline(deadline), work(exec_time) {}
 };
 
-struct Task {
-    Fraction phase, period, exec_time, relative_deadline;
+template<class T>
+struct BasicTask {
+    T phase, period, exec_time, relative_deadline;
     int next_job_id = 0;
-    Fraction next_release;
-    Task(Fraction phase, Fraction period, Fraction exec_time, Fraction relative_deadline) : phase(phase), period(period), exec_time(exec_time), relative_deadline(relative_deadline), next_release(phase) {}
-    Task() : Task(0, 0, 0, 0) {}
-    Task(Fraction period, Fraction exec_time, Fraction relative_deadline) : Task(0, period, exec_time, relative_deadline) {}
-    Task(Fraction period, Fraction exec_time) : Task(0, period, exec_time, period) {}
+    T next_release;
+    BasicTask(T phase, T period, T exec_time, T relative_deadline) : phase(phase), period(period), exec_time(exec_time), relative_deadline(relative_deadline), next_release(phase) {}
+    BasicTask() : BasicTask(0, 0, 0, 0) {}
+    BasicTask(T period, T exec_time, T relative_deadline) : BasicTask(0, period, exec_time, relative_deadline) {}
+    BasicTask(T period, T exec_time) : BasicTask(0, period, exec_time, period) {}
 
     // create next job for this task (task_id = id of this task which is handled externally)
-    Job next_job(int task_id);
+    BasicJob<T> next_job(int task_id);
 };
 
+typedef BasicJob<Time> Job;
+typedef BasicTask<Time> Task;
 typedef std::vector<Task> TaskSet; // task_set[i] = task with task id i
-typedef std::vector<Job> JobSet; // job_set[i] = job with job id i
-typedef std::vector<int> CoreState; // core_state[i] = job id of job scheduled on core i (-1 if idle)
+typedef std::vector<BasicTask<Fraction>> ExactTaskSet; // task set as generated/edited, converted to a TaskSet by SimModel::reset
+typedef std::vector<int> CoreState; // core_state[i] = slot of job scheduled on core i (-1 if idle)
+
+// reference to a job that stays valid across events
+// slots are recycled once a job finishes, gen tells apart the jobs that held the same slot
+struct JobHandle {
+    int slot = -1;
+    unsigned gen = 0;
+    bool operator==(const JobHandle& other) const { return slot == other.slot && gen == other.gen; }
+    bool operator!=(const JobHandle& other) const { return !(*this == other); }
+};
+
+struct JobView;
+
+// active jobs kept in a slot arena stored column-wise (struct of arrays), slot i is row i of every column
+// a job keeps its slot from release until it finishes, so slots stay valid between scheduling decisions
+// order lists the live slots in scheduling order (executing, then preempted, then fresh)
+// schedulers read jobs through JobView
+struct JobSet {
+    std::vector<long long> uid;
+    std::vector<int> task_id;
+    std::vector<int> job_id;
+    std::vector<Time> release_time;
+    std::vector<Time> exec_time;
+    std::vector<Time> work; // not on JobView so schedulers only see the WCET
+    std::vector<Time> deadline; // TIME_MAX for free slots so whole column scans skip them
+    std::vector<Time> runtime;
+    std::vector<Time> overhead;
+    std::vector<int> preempt_count;
+    std::vector<int> migration_count;
+    std::vector<const Task*> source_task;
+    std::vector<int> core;
+    std::vector<char> running;
+    std::vector<int> event_id;
+    std::vector<unsigned> gen; // bumped each time the slot is freed
+
+    std::vector<int> order; // live slots
+    std::vector<int> free_slots;
+
+    // iterates live jobs in order
+    struct iterator {
+        const JobSet* jobs;
+        const int* slot;
+        JobView operator*() const;
+        iterator& operator++() { ++slot; return *this; }
+        bool operator!=(const iterator& other) const { return slot != other.slot; }
+    };
+
+    int size() const { return order.size(); }
+    bool empty() const { return order.empty(); }
+    int slots() const { return uid.size(); } // every slot id is below this
+    JobView operator[](int slot) const;
+    iterator begin() const { return {this, order.data()}; }
+    iterator end() const { return {this, order.data() + order.size()}; }
+
+    JobHandle handle(int slot) const { return {slot, gen[slot]}; }
+    bool contains(JobHandle handle) const { return handle.slot >= 0 && handle.slot < slots() && gen[handle.slot] == handle.gen; }
+
+    // store job in a free slot and append it to order, returns the slot
+    int add(const Job& job);
+
+    // free slot for reuse (the caller drops it from order)
+    void remove(int slot);
+
+    // copy of the job in slot
+    Job get(int slot) const;
+
+    void clear();
+
+    // apply f to every column
+    template<class F>
+    void forEachColumn(F f) {
+        f(uid); f(task_id); f(job_id);
+        f(release_time); f(exec_time); f(work); f(deadline); f(runtime); f(overhead);
+        f(preempt_count); f(migration_count); f(source_task);
+        f(core); f(running); f(event_id); f(gen);
+    }
+};
+
+// read-only view of one slot of a JobSet, fields of Job as accessors
+struct JobView {
+    const JobSet* jobs;
+    int slot;
+    long long uid() const { return jobs->uid[slot]; }
+    int task_id() const { return jobs->task_id[slot]; }
+    int job_id() const { return jobs->job_id[slot]; }
+    const Time& release_time() const { return jobs->release_time[slot]; }
+    const Time& exec_time() const { return jobs->exec_time[slot]; }
+    const Time& deadline() const { return jobs->deadline[slot]; }
+    const Time& runtime() const { return jobs->runtime[slot]; }
+    const Time& overhead() const { return jobs->overhead[slot]; }
+    int preempt_count() const { return jobs->preempt_count[slot]; }
+    int migration_count() const { return jobs->migration_count[slot]; }
+    const Task* source_task() const { return jobs->source_task[slot]; }
+    int core() const { return jobs->core[slot]; }
+    bool running() const { return jobs->running[slot]; }
+    JobHandle handle() const { return jobs->handle(slot); }
+};
+
+inline JobView JobSet::iterator::operator*() const { return {jobs, *slot}; }
+inline JobView JobSet::operator[](int slot) const { return {this, slot}; }
+
+// per job state for schedulers, indexed by slot
+// an entry not written since its slot was handed to a new job reads as T()
+template<class T>
+struct JobMap {
+    std::vector<JobHandle> owner;
+    std::vector<T> values;
+
+    T& operator[](JobView job) {
+        if (job.slot >= values.size()) {
+            owner.resize(job.jobs->slots());
+            values.resize(job.jobs->slots());
+        }
+        JobHandle handle = job.handle();
+        if (owner[job.slot] != handle) {
+            owner[job.slot] = handle;
+            values[job.slot] = T();
+        }
+        return values[job.slot];
+    }
+
+    // entry for job without writing it
+    T get(JobView job) const {
+        return job.slot < values.size() && owner[job.slot] == job.handle() ? values[job.slot] : T();
+    }
+
+    void clear() {
+        owner.clear();
+        values.clear();
+    }
+};
+
+// lcm of the denominators of all task parameters
+long long denominatorLcm(const ExactTaskSet& task_set);
+
+// model time units per task set time unit: denominatorLcm with MARISA_TICK_TIME, otherwise 1
+long long tickScale(const ExactTaskSet& task_set);
+
+// convert a task set duration to model time at time_scale (rounds up to the next tick)
+Time toTime(Fraction t, long long time_scale);
+
+// t * ratio (rounds down to a tick with MARISA_TICK_TIME)
+Time scaleTime(Time t, Fraction ratio);
+
+// lcm of task periods (0 if it does not fit in Time)
+Time hyperperiod(const TaskSet& task_set);
+
+// one core assignment change made by the incremental scheduler interface (slot -1 idles the core)
+struct CoreChange {
+    int core;
+    int slot;
+};
+typedef std::vector<CoreChange> ScheduleDelta;
 
 struct ScheduleDecision {
-    Fraction next_event = INT_MAX;
+    Time next_event = TIME_MAX;
     CoreState core_state;
-    ScheduleDecision(int cores) : core_state(CoreState(cores, -1)) {}
+    ScheduleDecision(int cores = 0) : core_state(CoreState(cores, -1)) {}
+
+    // every core idle and no next event, keeping the buffer
+    void reset(int cores) {
+        next_event = TIME_MAX;
+        core_state.assign(cores, -1);
+    }
 };
 
 struct ExecBlock {
-    enum EndState {PREEMPTED, COMPLETED, MISSED};
+    enum EndState {PREEMPTED, COMPLETED, MISSED, OVERHEAD}; // OVERHEAD blocks are switching overhead, the job made no progress
     int task_id, job_id; // task and job that executed
     int core; // core executed on
-    Fraction start; // start time
-    Fraction end; // end time
+    Time start; // start time
+    Time end; // end time
     EndState endState; // state of end
-    ExecBlock(int task_id, int job_id, int core, Fraction start, Fraction end, EndState endState) : task_id(task_id), job_id(job_id), core(core), start(start), end(end), endState(endState) {}
+    ExecBlock() : task_id(-1), job_id(-1), core(-1), start(0), end(0), endState(PREEMPTED) {}
+    ExecBlock(int task_id, int job_id, int core, Time start, Time end, EndState endState) : task_id(task_id), job_id(job_id), core(core), start(start), end(end), endState(endState) {}
+    // block of job from start to end (relative to origin, stored as absolute times)
+    ExecBlock(JobView job, Time start, Time end, Time origin = 0);
+};
+
+// pending model events, kept up to date by SimModel so next events are found without scanning
+// releases are keyed by task id, deadlines by an id handed out per active job, timers by scheduler chosen ids
+class EventQueue {
+    IndexedHeap<Time> releases;
+    IndexedHeap<Time> deadlines;
+    IndexedHeap<Time> timers;
+    std::vector<int> free_deadline_ids;
+    int deadline_id_count = 0;
+public:
+    EventQueue() {}
+
+    // clear all events and add the next release of each task
+    void reset(const TaskSet& task_set);
+
+    void setRelease(int task_id, Time time);
+
+    // add a job deadline, returns its id
+    int addDeadline(Time deadline);
+    void removeDeadline(int id);
+
+    // timers are registered by schedulers (cleared on reset)
+    void setTimer(int id, Time time);
+    void clearTimer(int id);
+
+    // task with the earliest pending release (queue must not be empty)
+    int nextReleaseTask() const;
+
+    // id of the earliest timer (there must be one)
+    int nextTimerId() const;
+
+    // earliest pending event of each kind (TIME_MAX if none)
+    Time nextRelease() const;
+    Time nextDeadline() const;
+    Time nextTimer() const;
+
+    // subtract shift from every event (see SimModel::rebase)
+    void shift(Time shift);
 };
 
 // holds exec blocks and handles adding new ones
+// blocks sit in a ring of fixed size chunks (allocated on first use, then reused) until a consumer drains them
+// a block continuing the newest unread block (same job and core, no gap) extends it instead of taking a new entry
+// blocks are numbered in the order they were recorded, merged blocks count once
 class ExecBlockStorage {
-    std::deque<ExecBlock> exec_blocks;
-    std::deque<ExecBlock> new_blocks;
 public:
-    ExecBlockStorage() {}
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    // what happens to unread blocks when the ring is full
+    enum Overflow {
+        DROP_OLDEST, // the oldest chunk of unread blocks is discarded (counted in dropped)
+        SPILL // the oldest chunk of unread blocks is appended to a file and drained from there first
+    };
+
+private:
+    std::vector<std::vector<ExecBlock>> chunks;
+    size_t first = 0; // oldest block in the ring
+    size_t next = 0; // number of the next block recorded
+    size_t read = 0; // next block handed out by drain (blocks before first are in the spill file)
+    mutable size_t sealed = 0; // blocks before this are never extended (sealing doesn't change what is stored)
+    size_t spill_begin = 0; // block at the start of the spill file
+    Overflow overflow = DROP_OLDEST;
+    std::string spill_path;
+    std::fstream spill;
+
+    ExecBlock& at(size_t block) { return chunks[block / CHUNK_SIZE % chunks.size()][block % CHUNK_SIZE]; }
+    const ExecBlock& at(size_t block) const { return chunks[block / CHUNK_SIZE % chunks.size()][block % CHUNK_SIZE]; }
+
+    // make room for one block
+    void evict();
+
+    // empty the spill file once everything in it has been read
+    void resetSpill();
+
+public:
+    size_t dropped = 0; // unread blocks discarded by DROP_OLDEST
+
+    // holds at most chunk_count * CHUNK_SIZE unread blocks in memory
+    ExecBlockStorage(size_t chunk_count = 64) : chunks(chunk_count) { assert(chunk_count > 0); }
+
+    // SPILL needs the path of a scratch file (truncated when opened), returns false and keeps DROP_OLDEST if it can't be opened
+    // empties out storage
+    bool setOverflow(Overflow overflow, const std::string& spill_path = "");
 
     // add a block to storage
-    void add_block(const Job& job, Fraction start, Fraction end);
+    void add_block(const ExecBlock& block);
 
     // empty out storage
     void clear();
 
-    // has new block
-    bool hasNext();
+    // has unread block
+    bool hasNext() const;
+
+    // copy up to max unread blocks to out, oldest first, returns the number copied
+    size_t drain(ExecBlock* out, size_t max);
 
-    // get next new block, move it to exec_blocks
-    ExecBlock getNext();
+    // number of blocks recorded (read and unread)
+    size_t size() const;
+
+    // stop the newest block from being extended (so truncating back to size() restores it as it is now)
+    void seal() const;
+
+    // drop the newest blocks until count are left (blocks already drained stay with the consumer)
+    void truncate(size_t count);
 };
 
 struct Scheduler {
@@ -83,37 +367,301 @@ struct Scheduler {
 
     const PriorityScheme priority_scheme;
     const MigrationDegree migration_degree;
+    EventQueue* events = nullptr; // event queue of the model being scheduled (set by SimModel::reset), used to register timers
     Scheduler(PriorityScheme priority_scheme, MigrationDegree migration_degree) : priority_scheme(priority_scheme), migration_degree(migration_degree) {}
 
     virtual void init(const TaskSet& task_set, int cores);
 
-    // assign jobs to cores
-    virtual ScheduleDecision schedule(const SimModel& model);
+    // assign jobs to cores by writing into sd, which comes in with every core idle and next_event TIME_MAX
+    // sd is reused between decisions, temporary buffers should come from model.scratch so a decision makes no heap allocations
+    virtual void schedule(const SimModel& model, ScheduleDecision& sd);
+
+    // shift any absolute times held by the scheduler back by shift (see SimModel::rebase)
+    virtual void rebase(Time shift);
+
+    // append any private state that affects future decisions to state, times relative to model.time
+    // two instants with equal model and scheduler state must lead to the same (shifted) schedule
+    virtual void fingerprint(const SimModel& model, std::vector<Time>& state) const;
+
+    // incremental interface, used instead of schedule when SimModel::use_incremental is set and incremental() is true
+    // each handler appends its changes against model.core_state to delta (empty on entry), model.core_state already holds the changes made earlier at the same time
+    // the model runs until the next release, deadline, timer or completion, so any other wakeup must be a timer
+    virtual bool incremental() const;
+    virtual void on_release(const SimModel& model, int slot, ScheduleDelta& delta);
+    virtual void on_complete(const SimModel& model, int slot, ScheduleDelta& delta); // slot is freed after the call
+    virtual void on_deadline(const SimModel& model, int slot, ScheduleDelta& delta); // job still active at its deadline, unless SimModel::ABORT (slot is freed after the call with DROP)
+    virtual void on_timer(const SimModel& model, int id, ScheduleDelta& delta); // timer id fired (it is cleared before the call)
+
+    // true if core states a and b are equally valid decisions for the current state
+    // used to check incremental decisions against schedule, default is the same set of jobs
+    virtual bool sameDecision(const SimModel& model, const CoreState& a, const CoreState& b) const;
+
+    // copy of the private state for SimModel::snapshot (nullptr if the scheduler keeps none past init)
+    virtual std::shared_ptr<const Scheduler> clone_state() const;
+
+    // take private state from state, a clone_state result or a scheduler of the same type
+    virtual void restore_state(const Scheduler& state);
+};
+
+// when jobs arrive and become ready, drawn by SimModel from its release_rng stream (default is strictly periodic)
+// a job's deadline counts from its arrival, its release_time is when it becomes ready
+struct ReleaseModel {
+    // time added to the minimum inter-arrival time (the task period) before the next arrival of task
+    virtual Time slack(const Task& task, int task_id, std::mt19937_64& rng) const;
+
+    // delay from a job's arrival until it is ready, at most the gap to the next arrival
+    virtual Time jitter(const Task& task, int task_id, std::mt19937_64& rng) const;
+};
+
+// execution time of each job, drawn by SimModel from its exec_rng stream (default is the WCET)
+// jobs keep the WCET as exec_time (what schedulers see) and carry the drawn time as work, so laxity based schedulers stay non-clairvoyant
+struct ExecModel {
+    // in (0, task.exec_time]
+    virtual Time execTime(const Task& task, int task_id, std::mt19937_64& rng) const;
+};
+
+// core time lost each time a job is put on a core (default is none)
+// a dispatched job holds its core for the cost before it makes progress, which shows as an OVERHEAD exec block
+// schedulers plan without it, a job held up is still running at the decision after its planned completion
+// PD2 expects costs in whole time units
+struct OverheadModel {
+    // cost of putting job on core, called before the job's core is updated (job.core() is where it last ran, -1 if it never ran)
+    virtual Time switchCost(const SimModel& model, JobView job, int core) const;
+};
+
+// changes core speeds at scheduling decisions (default keeps them)
+struct DvfsPolicy {
+    // called once the jobs of a decision are on their cores (model.core_state), speed[c] is the speed of core c until the next decision
+    // speeds must stay above 0, the model wakes early if a job on a sped up core finishes before sd.next_event
+    virtual void setSpeeds(const SimModel& model, std::vector<Fraction>& speed) const;
+};
+
+struct SimSnapshot;
+
+// running totals over finished jobs, memory does not grow with the number of jobs
+struct JobStats {
+    long long count = 0; // finished jobs
+    long long migrations = 0;
+    long long preemptions = 0;
+    double response_mean = 0; // response time (completion - release) in task set time units
+    double response_m2 = 0; // sum of squared differences from the mean (Welford)
+    double response_max = 0;
+
+    // fold in a job that finished response_time after its release
+    void add(const Job& job, double response_time);
+    double responseVariance() const;
+};
+
+// deadline outcomes of one task's jobs, memory does not grow with the number of jobs
+struct TardinessStats {
+    long long jobs = 0; // jobs that completed by their deadline or reached it unfinished
+    long long misses = 0; // jobs that reached their deadline unfinished (counted then, whether or not they complete later)
+    long long completed = 0;
+    long long dropped = 0;
+    double tardiness_sum = 0; // max(0, lateness) summed over completed jobs
+    double tardiness_max = 0;
+    double lateness_max = -std::numeric_limits<double>::infinity(); // completion - deadline in task set time units (negative if every job was early)
+
+    // fold in a job that reached its deadline unfinished
+    void miss();
+    // fold in a job that completed lateness after its deadline (a late job was already counted by miss)
+    void complete(double lateness);
+    // a missed job dropped at its deadline
+    void drop();
+    double missRatio() const;
+    double tardinessMean() const; // over completed jobs
+};
+
+// progress of a SimModel::run_until call
+struct SimProgress {
+    // why the run stopped: the stop condition held, the model cannot continue (a miss with ABORT or a steady state), or a SimLimits limit
+    enum Stop { FINISHED, HALTED, EVENT_LIMIT, TIME_LIMIT, CANCELLED };
+
+    Stop stop = FINISHED;
+    long long events = 0; // scheduling decisions made
+    double seconds = 0; // wall clock time spent
+
+    double eventsPerSecond() const { return seconds > 0 ? events / seconds : 0; }
+};
+
+// bounds on one SimModel::run_until call, checked before each scheduling decision
+struct SimLimits {
+    long long max_events = LLONG_MAX;
+    double max_seconds = std::numeric_limits<double>::infinity(); // wall clock
+    const std::atomic<bool>* cancel = nullptr; // stops the run once set (from any thread)
+    std::function<void(const SimProgress&)> progress; // called about every progress_interval seconds while running
+    double progress_interval = 1;
+};
+
+// receives simulation events, each hook defaults to doing nothing
+// jobs are live when passed and times are relative to model.origin (like job times) unless stated otherwise
+// attach at run time through SimModel::observers, or as a compile-time list through SimModel::run_observed
+struct SimObserver {
+    virtual void onReset(const SimModel& model, const ExactTaskSet& task_set) {} // after the model is reset with task_set (runtime observers only)
+    virtual void onRelease(const SimModel& model, JobView job) {} // job released at model.time
+    virtual void onSwitch(const SimModel& model, int core, int slot) {} // core changes to running slot (-1 if idle) at model.time
+    virtual void onDispatch(const SimModel& model, JobView job, int core) {} // job starts running on core at model.time
+    virtual void onPreempt(const SimModel& model, JobView job, int core) {} // job stops running on core at model.time without finishing
+    virtual void onMigrate(const SimModel& model, JobView job, int from, int to) {} // job resumes on core to after last running on core from
+    virtual void onExec(const SimModel& model, const ExecBlock& block) {} // block ran (absolute times)
+    virtual void onComplete(const SimModel& model, JobView job, Time time) {} // job completed at time
+    virtual void onMiss(const SimModel& model, JobView job) {} // job still active at its deadline
 };
 
 struct SimModel {
+    enum Verdict { UNKNOWN, SCHEDULABLE, UNSCHEDULABLE };
+
+    // what happens to a job still active at its deadline
+    // ABORT stops sim, CONTINUE runs the job to completion at its old priority, DROP discards it
+    // with CONTINUE and DROP the scheduler sees late jobs, which job-level fixed priority schedulers (GEDF, GDM, GFIFO) handle
+    enum MissPolicy { ABORT, CONTINUE, DROP };
+
     TaskSet task_set;
     Scheduler* scheduler = nullptr;
     ExecBlockStorage ebs;
     bool ebs_active = true;
+    bool use_incremental = false; // drive schedulers that support it through their incremental interface (set before reset)
+    bool verify_incremental = false; // also run the full schedule each decision and assert it matches the incremental one
+    std::vector<SimObserver*> observers; // notified of events by sim, step and run_until (attach before reset for onReset)
 
-    Fraction time = 0; // time of next unhandled scheduling decision
-    int missed = -1; // missed job time (-1 if none)
+    // job variation (set before reset, nullptr for periodic jobs at their WCET), each model draws from its own stream seeded by variation_seed
+    // steady state detection is skipped with variation since the streams never repeat
+    const ReleaseModel* release_model = nullptr;
+    const ExecModel* exec_model = nullptr;
+    unsigned long long variation_seed = 0;
+    const OverheadModel* overhead_model = nullptr; // switching costs (nullptr for free switches)
+
+    // uniform multiprocessor: a core at speed s does s units of work (exec time) per time unit
+    // schedulers pick jobs as if every core ran at 1 (completions are found at core speed) and fill idle cores from core 0,
+    // so list faster cores first (PD2 needs every core at 1)
+    std::vector<Fraction> speeds; // speed of each core after reset (set before reset, cores past the end run at 1)
+    const DvfsPolicy* dvfs_policy = nullptr; // changes core speeds at decisions (nullptr to keep them)
+    std::vector<Fraction> core_speed; // current speed of each core
+    long long speed_grid = 1; // work and completions at speeds other than 1 are rounded to 1 / speed_grid model time units (a tick with MARISA_TICK_TIME, otherwise the task set's denominatorLcm)
+    std::mt19937_64 release_rng;
+    std::mt19937_64 exec_rng;
+    EventQueue events;
+
+    Time time = 0; // time of next unhandled scheduling decision (relative to origin, as are all job and task times)
+    Time origin = 0; // absolute time of model time 0
+    Time rebase_period = 0; // origin is moved forward by multiples of this once time reaches it (0 to disable, hyperperiod after reset)
+    MissPolicy miss_policy = ABORT;
+    int missed = -1; // slot of the latest job to miss its deadline (-1 if none)
     int cores = 1; // number of CPU cores available
+    long long time_scale = 1; // model time units per task set time unit (ticks per unit with MARISA_TICK_TIME)
 
     long long cswitch_count = 0; // number of context switches
+    long long event_count = 0; // number of scheduling decisions
 
     JobSet active_jobs;
-    JobSet finished_jobs;
+    CoreState core_state; // slot of the active job on each core as of the last decision (-1 if idle)
+    JobStats stats; // totals over all finished jobs
+    std::vector<TardinessStats> task_stats; // deadline outcomes by task id (the miss that halts an ABORT run is only in missed)
+    bool keep_finished_jobs = true; // false to only fold finished jobs into stats
+    std::vector<Job> finished_jobs; // release and deadline stored as absolute times (empty unless keep_finished_jobs)
+
+    // steady state detection: the state is fingerprinted every hyperperiod from the first decision made with detection on,
+    // and at the first idle instant after each
+    // once a state repeats the schedule is periodic from then on, so sim stops
+    bool detect_steady_state = false;
+    Time steady_period = 0; // period the schedule repeats with once a state repeated (0 if none yet)
+    Time next_fingerprint = 0; // next instant on the hyperperiod grid to fingerprint at
+    bool idle_fingerprinted = false; // true once an idle instant was fingerprinted since the last aligned instant
+    std::shared_ptr<std::map<std::vector<Time>, Time>> fingerprints; // state -> absolute time it was seen (copied on write when shared with a snapshot)
+
+    // temporary buffers of sim and the schedulers, memory given back is reused so decisions stop allocating once the buffers reach their
+    // largest sizes (with keep_finished_jobs off and ebs full, steady state detection still allocates), requests over SCRATCH_BLOCK bytes go to the heap
+    static constexpr size_t SCRATCH_BLOCK = 1 << 16;
+    mutable std::pmr::unsynchronized_pool_resource scratch;
+    ScheduleDecision decision; // written by the scheduler each decision
+    ScheduleDelta delta; // changes of the latest incremental handler
 
-    SimModel() {}
+    SimModel() : scratch(std::pmr::pool_options{0, SCRATCH_BLOCK}) {}
     
     // reset and init task sim with given task set and scheduler
-    void reset(TaskSet task_set, Scheduler* scheduler, int cores);
+    // with MARISA_TICK_TIME the task set is rescaled by the lcm of its denominators so every value is a whole tick
+    void reset(const ExactTaskSet& task_set, Scheduler* scheduler, int cores);
+
+    // reset to continue from the current state of parent with scheduler
+    // scheduler takes the private state of parent's scheduler if it is the same type, otherwise it starts fresh from init
+    // exec blocks and finished jobs of parent are not carried over
+    // copies the task set, active jobs and event queue (O(tasks + active jobs + queued events)), only the fingerprints are shared
+    void fork(const SimModel& parent, Scheduler* scheduler);
+
+    // save the current state, snapshots are immutable so copies of one share storage
+    // the task set, active jobs and event queue are copied in (O(tasks + active jobs + queued events)), not shared with the model:
+    // every step rewrites job runtimes, release times and the queue, so a copy on write would be taken at the next step anyway
+    SimSnapshot snapshot() const;
+
+    // return to a snapshot taken from this model, dropping exec blocks and finished jobs recorded after it
+    // copies the snapshot's state back (same cost as taking it), the snapshot can be restored again
+    void restore(const SimSnapshot& snapshot);
+
+    // move origin forward by shift, keeping every stored time relative to it
+    void rebase(Time shift);
 
     // simulates to at least endTime (ignore if endTime <= buffer)
     // handles execBlocks, finding next event, and updating job object bookkeeping 
-    void sim(Fraction endTime);
+    SimProgress sim(Fraction endTime, const SimLimits& limits = SimLimits());
+
+    // make up to max_events scheduling decisions, returns how many were made (fewer once halted())
+    long long step(long long max_events = 1);
+
+    // simulate until done(*this) holds before a decision, the model halts or a limit is reached
+    SimProgress run_until(const std::function<bool(const SimModel&)>& done, const SimLimits& limits = SimLimits());
+
+    // run_until notifying list instead of observers, each of a type derived from SimObserver
+    // hooks are called directly (not virtually) so they can inline, and an empty list compiles them away
+    // defined in sim_loop.h, which must be included to use other lists
+    template<class... Observers>
+    SimProgress run_observed(const std::function<bool(const SimModel&)>& done, const SimLimits& limits, Observers&... list);
+
+    // true if sim cannot continue: a job missed with ABORT, or the schedule reached a steady state
+    bool halted() const;
+
+    // apply incremental scheduler changes to core_state
+    void apply(const ScheduleDelta& delta);
+
+    // proven outcome (hard real-time): UNSCHEDULABLE after a miss, SCHEDULABLE once a state repeated without one, otherwise UNKNOWN
+    Verdict verdict() const;
+
+    // append the state at the current time that determines the rest of the schedule, times relative to time
+    void fingerprint(std::vector<Time>& state) const;
+
+    // convert durations between task set time (exact) and model time (rounds up to the next tick)
+    Time toTime(Fraction t) const;
+    Fraction toExact(Time t) const;
+
+    // work a core at speed does in duration (rounded down) and time it takes to do work (rounded up), see speed_grid
+    // exact times would keep picking up denominators as jobs move between speeds
+    Time workIn(Time duration, Fraction speed) const;
+    Time timeFor(Time work, Fraction speed) const;
+};
+
+// state of a SimModel at one instant (see SimModel::snapshot)
+struct SimSnapshot {
+    std::shared_ptr<const TaskSet> task_set;
+    std::shared_ptr<const JobSet> active_jobs;
+    std::shared_ptr<const EventQueue> events;
+    std::shared_ptr<const Scheduler> scheduler_state;
+    std::shared_ptr<std::map<std::vector<Time>, Time>> fingerprints;
+    CoreState core_state;
+    std::vector<Fraction> core_speed;
+    JobStats stats;
+    std::vector<TardinessStats> task_stats;
+    std::mt19937_64 release_rng;
+    std::mt19937_64 exec_rng;
+    Time time = 0;
+    Time origin = 0;
+    Time rebase_period = 0;
+    Time steady_period = 0;
+    Time next_fingerprint = 0;
+    bool idle_fingerprinted = false;
+    int missed = -1;
+    long long cswitch_count = 0;
+    long long event_count = 0;
+    size_t finished_count = 0; // finished_jobs recorded before the snapshot
+    size_t block_count = 0; // exec blocks recorded before the snapshot
 };
 
 #endif
\ No newline at end of file
@@ -1,22 +1,68 @@
 #include "schedulers.h"
 
-ScheduleDecision EDZL::schedule(const SimModel& model) {
-    ScheduleDecision sd(model.cores);
-    auto priority_func = [&time = model.time](const Job& job) {
-        return job.deadline - time == job.exec_time - job.runtime ? Fraction(INT_MAX) : -job.deadline;
+void EDZL::schedule(const SimModel& model, ScheduleDecision& sd) {
+    // zero laxity (or less, once a job can't make its deadline) runs first
+    auto priority_func = [&time = model.time](JobView job) {
+        return job.deadline() - time <= job.exec_time() - job.runtime() ? TIME_MAX : -job.deadline();
     };
-    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Fraction>(model.active_jobs, model.cores, INT_MIN, priority_func));
-    sd.next_event = std::min(nextSchedEvent(model.task_set, model.active_jobs, model.time), nextJobCompletion(model.active_jobs, sd.core_state, model.time));
-    std::vector<bool> scheduled(model.active_jobs.size(), false);
-    for (int i : sd.core_state) {
-        if (i == -1) continue;
-        scheduled[i] = true;
-    }
-    for (int i = 0; i < model.active_jobs.size(); ++i) {
-        if (scheduled[i]) continue;
-        const Job& job = model.active_jobs[i];
-        Fraction event = job.deadline - (job.exec_time - job.runtime);
-        if (event > model.time) sd.next_event = std::min(sd.next_event, event);
+    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Time>(model.active_jobs, model.cores, -TIME_MAX, priority_func, &model.scratch));
+    sd.next_event = std::min(nextSchedEvent(model), nextJobCompletion(model, sd.core_state));
+    sd.next_event = std::min(sd.next_event, nextZeroLaxity(model.active_jobs, sd.core_state, model.time, &model.scratch));
+}
+
+
+// a promoted job keeps its key, laxity only drops while it waits and holds while it runs
+Time EDZL::key(const SimModel& model, JobView job) const {
+    return job.deadline() - model.time <= job.exec_time() - job.runtime() ? -TIME_MAX : job.deadline();
+}
+
+void EDZL::init(const TaskSet& task_set, int cores) {
+    IncrementalPriorityScheduler::init(task_set, cores);
+    zero_laxity.clear();
+}
+
+void EDZL::on_timer(const SimModel& model, int id, ScheduleDelta& delta) {
+    // promote waiting jobs that reached zero laxity
+    while (!zero_laxity.empty() && zero_laxity.top() <= model.time) {
+        int slot = zero_laxity.topId();
+        zero_laxity.erase(slot);
+        keys[slot] = -TIME_MAX;
+        ready.set(slot, keys[slot]);
     }
-    return sd;
+    updateTimer();
+    dispatch(model, delta);
+}
+
+void EDZL::rebase(Time shift) {
+    shiftKeys(shift);
+    zero_laxity.shift(shift);
 }
+
+std::shared_ptr<const Scheduler> EDZL::clone_state() const {
+    return std::make_shared<EDZL>(*this);
+}
+
+void EDZL::restore_state(const Scheduler& state) {
+    IncrementalPriorityScheduler::restore_state(state);
+    zero_laxity = static_cast<const EDZL&>(state).zero_laxity;
+}
+
+void EDZL::onWait(const SimModel& model, int slot) {
+    JobView job = model.active_jobs[slot];
+    if (key(model, job) != -TIME_MAX)
+        zero_laxity.set(slot, job.deadline() - (job.exec_time() - job.runtime()));
+    updateTimer();
+}
+
+void EDZL::onDispatch(const SimModel& model, int slot) {
+    // a job dispatched as it reaches zero laxity never sees its timer fire, promote it here
+    if (zero_laxity.contains(slot) && key(model, model.active_jobs[slot]) == -TIME_MAX)
+        keys[slot] = -TIME_MAX;
+    zero_laxity.erase(slot);
+    updateTimer();
+}
+
+void EDZL::updateTimer() {
+    if (zero_laxity.empty()) events->clearTimer(0);
+    else events->setTimer(0, zero_laxity.top());
+}
\ No newline at end of file
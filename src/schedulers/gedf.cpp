@@ -1,11 +1,21 @@
 #include "schedulers.h"
 
-ScheduleDecision GEDF::schedule(const SimModel& model) {
-    ScheduleDecision sd(model.cores);
-    auto priority_func = [](const Job& job) {
-        return -job.deadline;
+void GEDF::schedule(const SimModel& model, ScheduleDecision& sd) {
+    auto priority_func = [](JobView job) {
+        return -job.deadline();
     };
-    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Fraction>(model.active_jobs, model.cores, INT_MIN, priority_func));
-    sd.next_event = std::min(nextSchedEvent(model.task_set, model.active_jobs, model.time), nextJobCompletion(model.active_jobs, sd.core_state, model.time));
-    return sd;
+    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Time>(model.active_jobs, model.cores, -TIME_MAX, priority_func, &model.scratch));
+    sd.next_event = std::min(nextSchedEvent(model), nextJobCompletion(model, sd.core_state));
+}
+
+Time GEDF::key(const SimModel& model, JobView job) const {
+    return job.deadline();
+}
+
+void GEDF::rebase(Time shift) {
+    shiftKeys(shift);
+}
+
+std::shared_ptr<const Scheduler> GEDF::clone_state() const {
+    return std::make_shared<GEDF>(*this);
 }
\ No newline at end of file
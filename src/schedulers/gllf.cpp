@@ -4,13 +4,18 @@ void GLLF::init(const TaskSet& task_set, int cores) {
     valid_task_set = usesIntegerTime(task_set);
 }
 
-ScheduleDecision GLLF::schedule(const SimModel& model) {
-    ScheduleDecision sd(model.cores);
-    if (!valid_task_set) return sd; // don't schedule if tasks don't use integer time
-    auto priority_func = [](const Job& job) {
-        return -(job.deadline - (job.exec_time - job.runtime));
+void GLLF::schedule(const SimModel& model, ScheduleDecision& sd) {
+    if (!valid_task_set || model.time_scale != 1) return; // don't schedule if tasks don't use integer time (in task set units, a tick can be a fraction of one)
+    auto priority_func = [](JobView job) {
+        return -(job.deadline() - (job.exec_time() - job.runtime()));
     };
-    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Fraction>(model.active_jobs, model.cores, INT_MIN, priority_func));
-    sd.next_event = model.time + 1;
-    return sd;
+    Time best_waiting;
+    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Time>(model.active_jobs, model.cores, -TIME_MAX, priority_func, &model.scratch, &best_waiting));
+
+    // a running job's zero laxity time grows by one each quantum while a waiting job's stays, running jobs win ties (they come first in job order)
+    // so the assignment holds until a running job's passes the earliest waiting one
+    Time end = std::min(nextSchedEvent(model), nextJobCompletion(model, sd.core_state));
+    sd.next_event = quantumRunEnd(model, sd.core_state, end, [&](int slot, long long quanta) {
+        return priority_func(model.active_jobs[slot]) - quanta >= best_waiting;
+    });
 }
@@ -5,31 +5,30 @@
 #include <functional>
 
 // helper function to assign chosen jobs to cores
-void assignToCores(const JobSet& active_jobs, CoreState& core_state, std::vector<int> chosen_jobs) {
+void assignToCores(const JobSet& active_jobs, CoreState& core_state, const std::pmr::vector<int>& chosen_jobs) {
     assert(chosen_jobs.size() <= core_state.size());
-    sort(chosen_jobs.begin(), chosen_jobs.end());
-    
+
     // reassign chosen jobs already executing (mitigates context switches)
     for (int i : chosen_jobs)
-        if (active_jobs[i].running)
-            core_state[active_jobs[i].core] = i;
+        if (active_jobs[i].running())
+            core_state[active_jobs[i].core()] = i;
 
     // assign chosen jobs not executing
     int next_empty = -1;
     for (int i : chosen_jobs) {
         // skip executing jobs
-        if (active_jobs[i].running)
+        if (active_jobs[i].running())
             continue;
         
         // prioritize previous core ran on (mitigates job-level migrations)
         // if taken by job that is either fresh or migrating, swap places
-        if (active_jobs[i].core != -1) {
-            int prev_core = active_jobs[i].core;
+        if (active_jobs[i].core() != -1) {
+            int prev_core = active_jobs[i].core();
             if (core_state[prev_core] == -1) {
                 // assign to prev core
                 core_state[prev_core] = i;
                 continue;
-            } else if (active_jobs[core_state[prev_core]].core != prev_core) {
+            } else if (active_jobs[core_state[prev_core]].core() != prev_core) {
                 // swap with job on core
                 std::swap(core_state[prev_core], i);
             }
@@ -41,42 +40,52 @@ void assignToCores(const JobSet& active_jobs, CoreState& core_state, std::vector
     }
 }
 
-// helper function for getting the next job release
-Fraction nextJobRelease(const TaskSet& task_set, const JobSet& active_jobs, Fraction time) {
-    Fraction next_event = INT_MAX;
-    // job release
-    for (const Task& task : task_set)
-        next_event = std::min(next_event, task.next_release);
-    return next_event;
+Time nextSchedEvent(const SimModel& model) {
+    return std::min(model.events.nextRelease(), model.events.nextDeadline());
 }
 
-// helper function for getting the next job deadline
-Fraction nextJobDeadline(const TaskSet& task_set, const JobSet& active_jobs, Fraction time) {
-    Fraction next_event = INT_MAX;
-    // job deadline
-    for (const Job& job : active_jobs)
-        next_event = std::min(next_event, job.deadline);
-    return next_event;
+Time nextJobCompletion(const JobSet& active_jobs, const CoreState& core_state, Time time) {
+    Time next_completion = TIME_MAX;
+    for (int i : core_state) {
+        if (i == -1) continue;
+        JobView job = active_jobs[i];
+        next_completion = std::min(next_completion, time + job.exec_time() - job.runtime());
+    }
+    return next_completion;
 }
 
-// helper function for getting the next scheduling event
-Fraction nextSchedEvent(const TaskSet& task_set, const JobSet& active_jobs, Fraction time) {
-    return std::min(nextJobRelease(task_set, active_jobs, time), nextJobDeadline(task_set, active_jobs, time));
+Time nextJobCompletion(const SimModel& model, const CoreState& core_state) {
+    if (std::all_of(model.core_speed.begin(), model.core_speed.end(), [](Fraction speed) { return speed == 1; }))
+        return nextJobCompletion(model.active_jobs, core_state, model.time);
+    Time next_completion = TIME_MAX;
+    for (int c = 0; c < core_state.size(); ++c) {
+        int i = core_state[c];
+        if (i == -1) continue;
+        JobView job = model.active_jobs[i];
+        next_completion = std::min(next_completion, model.time + model.timeFor(job.exec_time() - job.runtime(), model.core_speed[c]));
+    }
+    return next_completion;
 }
 
-Fraction nextJobCompletion(const JobSet& active_jobs, const CoreState& core_state, Fraction time) {
-    Fraction next_completion = INT_MAX;
+Time nextZeroLaxity(const JobSet& active_jobs, const CoreState& core_state, Time time, std::pmr::memory_resource* scratch) {
+    std::pmr::vector<char> scheduled(active_jobs.slots(), false, scratch);
     for (int i : core_state) {
         if (i == -1) continue;
-        const Job& job = active_jobs[i];
-        next_completion = std::min(next_completion, time + job.exec_time - job.runtime);
+        scheduled[i] = true;
     }
-    return next_completion;
+    Time next_event = TIME_MAX;
+    for (int i : active_jobs.order) {
+        if (scheduled[i]) continue;
+        JobView job = active_jobs[i];
+        Time event = job.deadline() - (job.exec_time() - job.runtime());
+        if (event > time) next_event = std::min(next_event, event);
+    }
+    return next_event;
 }
 
 bool usesIntegerTime(const TaskSet& task_set) {
     for (const Task& task : task_set)
-        if (!task.phase.isInt() || !task.period.isInt() || !task.exec_time.isInt() || !task.relative_deadline.isInt())
+        if (!isInt(task.phase) || !isInt(task.period) || !isInt(task.exec_time) || !isInt(task.relative_deadline))
             return false;
     return true;
 };
@@ -6,23 +6,29 @@
 #include <cassert>
 #include <algorithm>
 #include <functional>
+#include <memory_resource>
 
-// helper function to assign chosen jobs to cores
-void assignToCores(const JobSet& active_jobs, CoreState& core_state, std::vector<int> chosen_jobs);
+// helper function to assign chosen jobs (slots listed in job order) to cores
+void assignToCores(const JobSet& active_jobs, CoreState& core_state, const std::pmr::vector<int>& chosen_jobs);
 
-// helper function to choose by highest priority then lowest index
+// helper function to choose by highest priority then earliest in job order
 // priority must be greater than priority_threshold to schedule
-template<class T>
-std::vector<int> chooseByPriority(const JobSet& active_jobs, int cores, T priority_threshold, std::function<T(const Job& job)> priority_func) {
-    std::vector<int> chosen_jobs;
-    std::vector<T> job_priorities;
+// returns the chosen slots in job order, allocated from scratch
+// best_unchosen (if given) is set to the highest priority of a job that could run but was not chosen (priority_threshold if none)
+template<class T, class F>
+std::pmr::vector<int> chooseByPriority(const JobSet& active_jobs, int cores, T priority_threshold, F priority_func, std::pmr::memory_resource* scratch, T* best_unchosen = nullptr) {
+    std::pmr::vector<int> chosen_jobs(scratch);
+    std::pmr::vector<T> job_priorities(scratch);
+    chosen_jobs.reserve(cores + 1);
     job_priorities.reserve(active_jobs.size());
-    for (const Job& job : active_jobs) {
+    for (JobView job : active_jobs) {
         job_priorities.push_back(priority_func(job));
     }
     auto cmp = [&job_priorities](int i, int j) {
         return job_priorities[i] == job_priorities[j] ? i < j : job_priorities[i] > job_priorities[j];
     };
+    if (best_unchosen)
+        *best_unchosen = priority_threshold;
     for (int i = 0; i < active_jobs.size(); ++i) {
         if (job_priorities[i] <= priority_threshold)
             continue;
@@ -30,18 +36,60 @@ std::vector<int> chooseByPriority(const JobSet& active_jobs, int cores, T priori
         std::push_heap(chosen_jobs.begin(), chosen_jobs.end(), cmp);
         if (chosen_jobs.size() == cores + 1) {
             std::pop_heap(chosen_jobs.begin(), chosen_jobs.end(), cmp);
+            if (best_unchosen)
+                *best_unchosen = std::max(*best_unchosen, job_priorities[chosen_jobs.back()]);
             chosen_jobs.pop_back();
         }
     }
+    std::sort(chosen_jobs.begin(), chosen_jobs.end());
+    for (int& i : chosen_jobs)
+        i = active_jobs.order[i];
     return chosen_jobs;
 }
 
-// helper function for getting the next scheduling event
-Fraction nextJobRelease(const TaskSet& task_set, const JobSet& active_jobs, Fraction time);
-Fraction nextJobDeadline(const TaskSet& task_set, const JobSet& active_jobs, Fraction time);
-Fraction nextSchedEvent(const TaskSet& task_set, const JobSet& active_jobs, Fraction time);
-Fraction nextJobCompletion(const JobSet& active_jobs, const CoreState& core_state, Fraction time);
+// helper function for getting the next job completion
+Time nextJobCompletion(const JobSet& active_jobs, const CoreState& core_state, Time time);
 
+// next release or deadline, read from the model's event queue instead of scanning
+Time nextSchedEvent(const SimModel& model);
+
+// next completion of the jobs in core_state at the speeds of their cores (SimModel::core_speed)
+Time nextJobCompletion(const SimModel& model, const CoreState& core_state);
+
+// earliest time after time that an unscheduled job reaches zero laxity
+Time nextZeroLaxity(const JobSet& active_jobs, const CoreState& core_state, Time time, std::pmr::memory_resource* scratch);
+
+// for quantum based schedulers: the end of the run of quanta from model.time over which the jobs in core_state provably keep their cores
+// keeps(slot, j) tells if running job slot still gets its core for the quantum j quanta after model.time (j >= 1), once false it must stay false
+// end bounds the run (the next release, deadline, completion or other change the caller knows of)
+template<class F>
+Time quantumRunEnd(const SimModel& model, const CoreState& core_state, Time end, F keeps) {
+    // a job slowed by switching overhead or core speed can finish mid quantum, the fraction up to end runs on its own
+    long long quanta = floorDiv(end - model.time, Time(1));
+    if (quanta == 0) return end;
+    for (int i : core_state) {
+        if (i == -1) continue;
+        // first quantum job i may lose its core (keeps holds up to lo, fails by hi)
+        // runs are usually short, so probe 1, 2, 4, ... quanta before bisecting
+        long long lo = 0;
+        long long hi = 1;
+        while (hi < quanta && keeps(i, hi)) {
+            lo = hi;
+            hi *= 2;
+        }
+        hi = std::min(hi, quanta);
+        while (hi - lo > 1) {
+            long long mid = lo + (hi - lo) / 2;
+            if (keeps(i, mid)) lo = mid;
+            else hi = mid;
+        }
+        quanta = hi;
+    }
+    return model.time + quanta;
+}
+
+// true if all task parameters are whole model time units (always true with MARISA_TICK_TIME, where a unit is one tick)
+// PD2 and GLLF also need SimModel::time_scale == 1 so a quantum is one task set time unit in both builds
 bool usesIntegerTime(const TaskSet& task_set);
 
 
@@ -0,0 +1,102 @@
+#include "schedulers.h"
+
+void IncrementalPriorityScheduler::init(const TaskSet& task_set, int cores) {
+    ready.clear();
+    keys.clear();
+}
+
+bool IncrementalPriorityScheduler::incremental() const {
+    return true;
+}
+
+void IncrementalPriorityScheduler::on_release(const SimModel& model, int slot, ScheduleDelta& delta) {
+    if (slot >= keys.size())
+        keys.resize(model.active_jobs.slots());
+    keys[slot] = key(model, model.active_jobs[slot]);
+    ready.set(slot, keys[slot]);
+    onWait(model, slot);
+    dispatch(model, delta);
+}
+
+void IncrementalPriorityScheduler::on_complete(const SimModel& model, int slot, ScheduleDelta& delta) {
+    ready.erase(slot);
+    onDispatch(model, slot);
+    dispatch(model, delta);
+}
+
+void IncrementalPriorityScheduler::on_deadline(const SimModel& model, int slot, ScheduleDelta& delta) {
+    // a dropped job leaves like a completed one, a late job keeps its key
+    if (model.miss_policy == SimModel::DROP)
+        on_complete(model, slot, delta);
+}
+
+void IncrementalPriorityScheduler::dispatch(const SimModel& model, ScheduleDelta& delta) {
+    std::pmr::vector<int> core_state(model.core_state.begin(), model.core_state.end(), &model.scratch);
+    while (!ready.empty()) {
+        int slot = ready.topId();
+
+        // with SimModel::DROP a late job still waiting is dropped later in this step, it never gets a core
+        if (model.miss_policy == SimModel::DROP && model.active_jobs.deadline[slot] <= model.time) {
+            ready.erase(slot);
+            continue;
+        }
+
+        // prefer the core the job last ran on, then any idle core (mitigates job-level migrations)
+        int prev_core = model.active_jobs.core[slot];
+        int core = prev_core != -1 && core_state[prev_core] == -1 ? prev_core : -1;
+        for (int c = 0; core == -1 && c < core_state.size(); ++c)
+            if (core_state[c] == -1) core = c;
+
+        // otherwise preempt the running job with the highest key if it is strictly higher
+        if (core == -1) {
+            core = 0;
+            for (int c = 1; c < core_state.size(); ++c)
+                if (keys[core_state[c]] > keys[core_state[core]]) core = c;
+            if (keys[core_state[core]] <= ready.top()) break;
+        }
+        ready.erase(slot);
+        onDispatch(model, slot);
+        int preempted = core_state[core];
+        if (preempted != -1) {
+            ready.set(preempted, keys[preempted]);
+            onWait(model, preempted);
+        }
+        core_state[core] = slot;
+        delta.push_back({core, slot});
+    }
+}
+
+bool IncrementalPriorityScheduler::sameDecision(const SimModel& model, const CoreState& a, const CoreState& b) const {
+    // ties between equal keys may be broken differently, so compare the keys that run
+    auto runningKeys = [&](const CoreState& core_state) {
+        std::vector<Time> res;
+        for (int i : core_state)
+            if (i != -1) res.push_back(key(model, model.active_jobs[i]));
+        std::sort(res.begin(), res.end());
+        return res;
+    };
+    return runningKeys(a) == runningKeys(b);
+}
+
+void IncrementalPriorityScheduler::fingerprint(const SimModel& model, std::vector<Time>& state) const {
+    // the ready queue breaks ties by slot
+    if (!model.use_incremental) return;
+    for (int i : model.active_jobs.order)
+        state.push_back(i);
+}
+
+void IncrementalPriorityScheduler::restore_state(const Scheduler& state) {
+    const IncrementalPriorityScheduler& scheduler = static_cast<const IncrementalPriorityScheduler&>(state);
+    ready = scheduler.ready;
+    keys = scheduler.keys;
+}
+
+void IncrementalPriorityScheduler::onWait(const SimModel& model, int slot) {}
+
+void IncrementalPriorityScheduler::onDispatch(const SimModel& model, int slot) {}
+
+void IncrementalPriorityScheduler::shiftKeys(Time shift) {
+    ready.shift(shift);
+    for (Time& key : keys)
+        key -= shift;
+}
@@ -1,46 +1,66 @@
 #include "schedulers.h"
 
 void LLREF::init(const TaskSet& task_set, int cores) {
+    assert(EXACT_TIME && "LLREF needs exact time (local exec times are fractions of a tick)");
     next_event = 0;
     local_exec.clear();
 }
 
-ScheduleDecision LLREF::schedule(const SimModel& model) {
-    ScheduleDecision sd(model.cores);
-    sd.next_event = nextSchedEvent(model.task_set, model.active_jobs, model.time);
+void LLREF::rebase(Time shift) {
+    next_event -= shift;
+}
+
+void LLREF::fingerprint(const SimModel& model, std::vector<Time>& state) const {
+    state.push_back(next_event - model.time);
+    for (JobView job : model.active_jobs)
+        state.push_back(local_exec.get(job));
+}
+
+std::shared_ptr<const Scheduler> LLREF::clone_state() const {
+    return std::make_shared<LLREF>(*this);
+}
+
+void LLREF::restore_state(const Scheduler& state) {
+    const LLREF& llref = static_cast<const LLREF&>(state);
+    next_event = llref.next_event;
+    local_exec = llref.local_exec;
+}
+
+void LLREF::schedule(const SimModel& model, ScheduleDecision& sd) {
+    if (!EXACT_TIME) return; // don't schedule if time is not exact (local exec times are fractions of a tick)
+    sd.next_event = nextSchedEvent(model);
 
     // enter next TL plane
     if (sd.next_event > next_event) {
-        Fraction tl_time = sd.next_event - next_event;
+        Time tl_time = sd.next_event - next_event;
         local_exec.clear();
-        for (const Job& job : model.active_jobs)
-            local_exec[job.uid] = tl_time * (job.exec_time / (job.deadline - job.release_time));
+        for (JobView job : model.active_jobs)
+            local_exec[job] = tl_time * (job.exec_time() / (job.deadline() - job.release_time()));
         next_event = sd.next_event;
     }
 
     // schedule by max remaining local exec time
-    auto priority_func = [&local_exec = local_exec](const Job& job) {
-        return local_exec[job.uid];
+    auto priority_func = [&local_exec = local_exec](JobView job) {
+        return local_exec[job];
     };
-    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Fraction>(model.active_jobs, model.cores, 0, priority_func));
+    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<Time>(model.active_jobs, model.cores, 0, priority_func, &model.scratch));
 
     // find next secondary event
-    std::vector<Fraction> next_secondary(model.active_jobs.size(), -1);
+    std::pmr::vector<Time> next_secondary(model.active_jobs.slots(), -1, &model.scratch);
     for (int i : sd.core_state) {
         if (i == -1) continue;
-        next_secondary[i] = model.time + local_exec[model.active_jobs[i].uid];
+        next_secondary[i] = model.time + local_exec[model.active_jobs[i]];
     }
-    for (int i = 0; i < model.active_jobs.size(); ++i) {
+    for (int i : model.active_jobs.order) {
         if (next_secondary[i] != -1) continue;
-        next_secondary[i] = next_event - local_exec[model.active_jobs[i].uid];
+        next_secondary[i] = next_event - local_exec[model.active_jobs[i]];
     }
-    for (int i = 0; i < model.active_jobs.size(); ++i) {
+    for (int i : model.active_jobs.order) {
         if (next_secondary[i] <= model.time || next_secondary[i] >= sd.next_event) continue;
         sd.next_event = next_secondary[i];
     }
 
     // update local exec times
     for (int i : sd.core_state)
-        if (i != -1) local_exec[model.active_jobs[i].uid] -= sd.next_event - model.time;
-    return sd;
+        if (i != -1) local_exec[model.active_jobs[i]] -= sd.next_event - model.time;
 }
\ No newline at end of file
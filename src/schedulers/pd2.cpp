@@ -4,53 +4,74 @@ void PD2::init(const TaskSet& task_set, int cores) {
     valid_task_set = usesIntegerTime(task_set);
 }
 
-ScheduleDecision PD2::schedule(const SimModel& model) {
-    ScheduleDecision sd(model.cores);
-    if (!valid_task_set) return sd; // don't schedule if tasks don't use integer time
-    auto priority_func = [early_release = this->early_release, &time = model.time](const Job& job) {
-        auto get_itv = [&job](int work_done) {
-            int rel_deadline = job.deadline.getNum() - job.release_time.getNum();
-            return std::make_pair(
-                (int)job.release_time.getNum() + std::max(0, ((work_done - 1) * rel_deadline + (int)job.exec_time.getNum()) / (int)job.exec_time.getNum() - 1),
-                (int)job.release_time.getNum() + std::min(rel_deadline - 1, (work_done * rel_deadline + (int)job.exec_time.getNum() - 1) / (int)job.exec_time.getNum() - 1)
-            );
-        };
-        std::pair<int,int> first_itv = get_itv((int)job.runtime.getNum() + 1);
-
-        // handle early releasing
-        if (early_release)
-            first_itv.first = 0;
-        else if (first_itv.first > time)
-            return (long long)-1;
-
-        // generate intervals to next group deadline
-        int curr_work = job.runtime.getNum();
-        std::pair<int,int> curr_itv, next_itv = first_itv;
-        bool overlapping_next;
-        int curr_itv_len;
-        auto step_itv = [&]() {
-            curr_itv = next_itv;
-            next_itv = get_itv(++curr_work + 1);
-            overlapping_next = curr_itv.second == next_itv.first;
-            curr_itv_len = curr_itv.second + 1 - curr_itv.first;
-        };
+// window (release, deadline) of subtask work_done of job
+static std::pair<int,int> window(JobView job, int work_done) {
+    int rel_deadline = toInt(job.deadline()) - toInt(job.release_time());
+    return std::make_pair(
+        (int)toInt(job.release_time()) + std::max(0, ((work_done - 1) * rel_deadline + (int)toInt(job.exec_time())) / (int)toInt(job.exec_time()) - 1),
+        (int)toInt(job.release_time()) + std::min(rel_deadline - 1, (work_done * rel_deadline + (int)toInt(job.exec_time()) - 1) / (int)toInt(job.exec_time()) - 1)
+    );
+}
+
+// priority of job's next subtask once it has done work_done quanta, at time (-1 if the subtask is not released yet)
+// strictly decreasing in work_done since subtask deadlines are
+static long long priority(JobView job, int work_done, Time time, bool early_release) {
+    std::pair<int,int> first_itv = window(job, work_done + 1);
+
+    // handle early releasing
+    if (early_release)
+        first_itv.first = 0;
+    else if (first_itv.first > time)
+        return (long long)-1;
+
+    // generate intervals to next group deadline
+    int curr_work = work_done;
+    std::pair<int,int> curr_itv, next_itv = first_itv;
+    bool overlapping_next;
+    int curr_itv_len;
+    auto step_itv = [&]() {
+        curr_itv = next_itv;
+        next_itv = window(job, ++curr_work + 1);
+        overlapping_next = curr_itv.second == next_itv.first;
+        curr_itv_len = curr_itv.second + 1 - curr_itv.first;
+    };
+    step_itv();
+
+    // priority order: deadline, is heavy, itv overlaps next, next group deadline
+    // priority bitstring (64 bits):
+    //   32b - deadline
+    //    1b - first interval overlaps next
+    //   31b - next group deadline
+    long long priority = (long long)(INT_MAX - first_itv.second) << 32; // deadline of current interval
+    if (overlapping_next) // first itv overlapping next
+        priority += (long long)1 << 31;
+
+    while (curr_work < job.exec_time() && overlapping_next && curr_itv_len == 2)
         step_itv();
+    priority += curr_itv.first + 1; // next group deadline
+    return priority;
+}
 
-        // priority order: deadline, is heavy, itv overlaps next, next group deadline
-        // priority bitstring (64 bits):
-        //   32b - deadline
-        //    1b - first interval overlaps next
-        //   31b - next group deadline
-        long long priority = (long long)(INT_MAX - first_itv.second) << 32; // deadline of current interval
-        if (overlapping_next) // first itv overlapping next
-            priority += (long long)1 << 31;
-
-        while (curr_work < job.exec_time && overlapping_next && curr_itv_len == 2)
-            step_itv();
-        priority += curr_itv.first + 1; // next group deadline
-        return priority;
+void PD2::schedule(const SimModel& model, ScheduleDecision& sd) {
+    if (!valid_task_set || model.time_scale != 1) return; // don't schedule if tasks don't use integer time (in task set units, a tick can be a fraction of one)
+    auto priority_func = [early_release = this->early_release, &time = model.time](JobView job) {
+        return priority(job, toInt(job.runtime()), time, early_release);
     };
-    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<long long>(model.active_jobs, model.cores, -1, priority_func));
-    sd.next_event = model.time + 1;
-    return sd;
+    long long best_waiting;
+    assignToCores(model.active_jobs, sd.core_state, chooseByPriority<long long>(model.active_jobs, model.cores, -1, priority_func, &model.scratch, &best_waiting));
+
+    // skip the quanta where nothing changes: the assignment holds while each running job's next subtask is released and beats the
+    // best waiting job (running jobs win ties as they come first in job order), and until a waiting job's next subtask is released
+    Time end = std::min(nextSchedEvent(model), nextJobCompletion(model, sd.core_state));
+    if (!early_release) {
+        for (JobView job : model.active_jobs) {
+            int release = window(job, toInt(job.runtime()) + 1).first;
+            if (release > model.time) end = std::min(end, (Time)release);
+        }
+    }
+    sd.next_event = quantumRunEnd(model, sd.core_state, end, [&](int slot, long long quanta) {
+        JobView job = model.active_jobs[slot];
+        long long job_priority = priority(job, toInt(job.runtime()) + quanta, model.time + quanta, early_release);
+        return job_priority != -1 && job_priority >= best_waiting;
+    });
 }
\ No newline at end of file
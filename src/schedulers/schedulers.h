@@ -2,41 +2,89 @@
 #define SCHEDULERS_H
 
 #include <vector>
-#include <unordered_map>
 #include <utility>
 #include "../model.h"
 #include "helper_funcs.h"
 
+// base for schedulers that run the jobs with the lowest keys, with an incremental interface
+// a job's key is set when it is released and must not change afterwards unless the subclass updates it
+struct IncrementalPriorityScheduler : public Scheduler {
+    IndexedHeap<Time> ready; // waiting jobs by key (id = slot)
+    std::vector<Time> keys; // key of the job in each slot
+    IncrementalPriorityScheduler(PriorityScheme priority_scheme, MigrationDegree migration_degree) : Scheduler(priority_scheme, migration_degree) {}
+
+    // key of job at model.time (lower runs first)
+    virtual Time key(const SimModel& model, JobView job) const = 0;
+
+    void init(const TaskSet& task_set, int cores) override;
+    bool incremental() const override;
+    void on_release(const SimModel& model, int slot, ScheduleDelta& delta) override;
+    void on_complete(const SimModel& model, int slot, ScheduleDelta& delta) override;
+    void on_deadline(const SimModel& model, int slot, ScheduleDelta& delta) override;
+    bool sameDecision(const SimModel& model, const CoreState& a, const CoreState& b) const override;
+    void fingerprint(const SimModel& model, std::vector<Time>& state) const override;
+    void restore_state(const Scheduler& state) override;
+
+protected:
+    // a job started waiting or was dispatched
+    virtual void onWait(const SimModel& model, int slot);
+    virtual void onDispatch(const SimModel& model, int slot);
+
+    // fill idle cores from the ready queue, then preempt running jobs with higher keys (changes appended to delta)
+    void dispatch(const SimModel& model, ScheduleDelta& delta);
+
+    // subtract shift from every key (for keys that are times)
+    void shiftKeys(Time shift);
+};
+
 // Global Eearliest Deadline First
-struct GEDF : public Scheduler {
-    GEDF() : Scheduler(PriorityScheme::JOB_LEVEL_DYN, MigrationDegree::FULL) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+struct GEDF : public IncrementalPriorityScheduler {
+    GEDF() : IncrementalPriorityScheduler(PriorityScheme::JOB_LEVEL_DYN, MigrationDegree::FULL) {}
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
+    Time key(const SimModel& model, JobView job) const override;
+    void rebase(Time shift) override;
+    std::shared_ptr<const Scheduler> clone_state() const override;
 };
 
 // Global LLF on Discrete Time
 struct GLLF : public Scheduler {
     bool valid_task_set = false;
     GLLF() : Scheduler(PriorityScheme::JOB_LEVEL_DYN, MigrationDegree::FULL) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
     void init(const TaskSet& task_set, int cores) override;
 };
 
 // Global Deadline Monotonic (Rate Monotonic if implicit deadlines used)
-struct GDM : public Scheduler {
-    GDM() : Scheduler(PriorityScheme::STATIC, MigrationDegree::FULL) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+struct GDM : public IncrementalPriorityScheduler {
+    GDM() : IncrementalPriorityScheduler(PriorityScheme::STATIC, MigrationDegree::FULL) {}
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
+    Time key(const SimModel& model, JobView job) const override;
+    std::shared_ptr<const Scheduler> clone_state() const override;
 };
 
 // Global First In First Out
 struct GFIFO : public Scheduler {
     GFIFO() : Scheduler(PriorityScheme::STATIC, MigrationDegree::RESTRICTED) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
 };
 
 // Earliest Deadline First until Zero Laxity
-struct EDZL : public Scheduler {
-    EDZL() : Scheduler(PriorityScheme::JOB_LEVEL_DYN, MigrationDegree::FULL) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+// incrementally a waiting job's key drops to -TIME_MAX through a timer (id 0) when it reaches zero laxity
+struct EDZL : public IncrementalPriorityScheduler {
+    IndexedHeap<Time> zero_laxity; // waiting jobs by the time they reach zero laxity (id = slot)
+    EDZL() : IncrementalPriorityScheduler(PriorityScheme::JOB_LEVEL_DYN, MigrationDegree::FULL) {}
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
+    Time key(const SimModel& model, JobView job) const override;
+    void init(const TaskSet& task_set, int cores) override;
+    void on_timer(const SimModel& model, int id, ScheduleDelta& delta) override;
+    void rebase(Time shift) override;
+    std::shared_ptr<const Scheduler> clone_state() const override;
+    void restore_state(const Scheduler& state) override;
+
+protected:
+    void onWait(const SimModel& model, int slot) override;
+    void onDispatch(const SimModel& model, int slot) override;
+    void updateTimer();
 };
 
 // PD2 with Intra Sporadic and optional Early Releasing on Discrete Time
@@ -44,27 +92,35 @@ struct PD2 : public Scheduler {
     bool early_release;
     bool valid_task_set = false;
     PD2(bool early_release = true) : Scheduler(PriorityScheme::UNRESTRICTED_DYN, MigrationDegree::FULL), early_release(early_release) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
     void init(const TaskSet& task_set, int cores) override;
 };
 
 // Largest Lowest Remaining Execution First
 struct LLREF : public Scheduler {
-    Fraction next_event;
-    std::unordered_map<long long, Fraction> local_exec;
+    Time next_event;
+    JobMap<Time> local_exec;
     LLREF() : Scheduler(PriorityScheme::UNRESTRICTED_DYN, MigrationDegree::FULL) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
     void init(const TaskSet& task_set, int cores) override;
+    void rebase(Time shift) override;
+    void fingerprint(const SimModel& model, std::vector<Time>& state) const override;
+    std::shared_ptr<const Scheduler> clone_state() const override;
+    void restore_state(const Scheduler& state) override;
 };
 
 // UEDF Optimal Scheduler
 struct UEDF : public Scheduler {
-    Fraction next_event;
-    std::vector<std::vector<std::pair<int,Fraction>>> core_budgets; // core -> (task id, budget)
+    Time next_event;
+    std::vector<std::vector<std::pair<int,Time>>> core_budgets; // core -> (task id, budget)
     std::vector<int> task_next_job;
     UEDF() : Scheduler(PriorityScheme::UNRESTRICTED_DYN, MigrationDegree::FULL) {}
-    ScheduleDecision schedule(const SimModel& model) override;
+    void schedule(const SimModel& model, ScheduleDecision& sd) override;
     void init(const TaskSet& task_set, int cores) override;
+    void rebase(Time shift) override;
+    void fingerprint(const SimModel& model, std::vector<Time>& state) const override;
+    std::shared_ptr<const Scheduler> clone_state() const override;
+    void restore_state(const Scheduler& state) override;
 };
 
 #endif
\ No newline at end of file
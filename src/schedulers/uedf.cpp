@@ -2,18 +2,51 @@
 #include <numeric>
 #include <algorithm>
 
-void resetBudgets(std::vector<std::vector<std::pair<int,Fraction>>>& core_budgets, int cores) {
-    core_budgets = std::vector<std::vector<std::pair<int,Fraction>>>(cores);
+// empty every core's budgets, keeping their buffers
+void resetBudgets(std::vector<std::vector<std::pair<int,Time>>>& core_budgets, int cores) {
+    core_budgets.resize(cores);
+    for (auto& budgets : core_budgets)
+        budgets.clear();
 };
 
 void UEDF::init(const TaskSet& task_set, int cores) {
+    assert(EXACT_TIME && "U-EDF needs exact time (budgets are fractions of a tick)");
     next_event = 0;
     resetBudgets(core_budgets, cores);
     task_next_job = std::vector<int>(task_set.size(), -1);
 }
 
-ScheduleDecision UEDF::schedule(const SimModel& model) {
-    ScheduleDecision sd(model.cores);
+void UEDF::rebase(Time shift) {
+    next_event -= shift;
+}
+
+void UEDF::fingerprint(const SimModel& model, std::vector<Time>& state) const {
+    state.push_back(next_event - model.time);
+    for (const auto& budgets : core_budgets) {
+        state.push_back(budgets.size());
+        for (const auto& budget : budgets) {
+            state.push_back(budget.first);
+            state.push_back(budget.second);
+        }
+    }
+    // job ids only matter through whether a task released since the last decision
+    for (int i = 0; i < model.task_set.size(); ++i)
+        state.push_back(model.task_set[i].next_job_id != task_next_job[i]);
+}
+
+std::shared_ptr<const Scheduler> UEDF::clone_state() const {
+    return std::make_shared<UEDF>(*this);
+}
+
+void UEDF::restore_state(const Scheduler& state) {
+    const UEDF& uedf = static_cast<const UEDF&>(state);
+    next_event = uedf.next_event;
+    core_budgets = uedf.core_budgets;
+    task_next_job = uedf.task_next_job;
+}
+
+void UEDF::schedule(const SimModel& model, ScheduleDecision& sd) {
+    if (!EXACT_TIME) return; // don't schedule if time is not exact (budgets are fractions of a tick)
     bool new_job = false;
     for (int i = 0; i < model.task_set.size(); ++i) {
         if (model.task_set[i].next_job_id != task_next_job[i]) {
@@ -22,29 +55,37 @@ ScheduleDecision UEDF::schedule(const SimModel& model) {
         }
     }
 
+    // a task's budget runs its oldest job (a late one stays active next to the newer job with SimModel::CONTINUE)
+    std::pmr::vector<int> task_job(model.task_set.size(), -1, &model.scratch);
+    for (JobView job : model.active_jobs) {
+        int& oldest = task_job[job.task_id()];
+        if (oldest == -1 || job.job_id() < model.active_jobs[oldest].job_id())
+            oldest = job.slot;
+    }
+
     // allocates task budgets to cores
     if (new_job) {
         resetBudgets(core_budgets, model.cores);
-        next_event = nextJobRelease(model.task_set, model.active_jobs, model.time);
-        std::vector<int> ordered_tasks(model.task_set.size());
-        std::vector<Fraction> task_deadline(model.task_set.size(), INT_MAX);
-        for (const Job& job : model.active_jobs) {
-            task_deadline[job.task_id] = job.deadline;
-        }
+        next_event = model.events.nextRelease();
+        std::pmr::vector<int> ordered_tasks(model.task_set.size(), &model.scratch);
+        std::pmr::vector<Time> task_deadline(model.task_set.size(), TIME_MAX, &model.scratch);
+        for (int tid = 0; tid < model.task_set.size(); ++tid)
+            if (task_job[tid] != -1) task_deadline[tid] = model.active_jobs.deadline[task_job[tid]];
         std::iota(ordered_tasks.begin(), ordered_tasks.end(), 0);
         auto cmp = [&](int i, int j) {
             return task_deadline[i] < task_deadline[j];
         };
         std::sort(ordered_tasks.begin(), ordered_tasks.end(), cmp);
-        Fraction delta_time = next_event - model.time;
-        std::vector<Fraction> core_budget(model.cores, delta_time);
+        Time delta_time = next_event - model.time;
+        std::pmr::vector<Time> core_budget(model.cores, delta_time, &model.scratch);
         int core = 0;
         for (int tid : ordered_tasks) {
+            if (core >= model.cores) break; // every core is full (an overloaded set with SimModel::CONTINUE)
             const Task& task = model.task_set[tid];
-            Fraction task_budget = delta_time * (task.exec_time / task.period);
+            Time task_budget = delta_time * (task.exec_time / task.period);
             while (task_budget > 0) {
                 if (core_budget[core] == 0 && ++core >= model.cores) break;
-                Fraction alloc_amount = std::min(task_budget, core_budget[core]);
+                Time alloc_amount = std::min(task_budget, core_budget[core]);
                 core_budgets[core].emplace_back(tid, alloc_amount);
                 task_budget -= alloc_amount;
                 core_budget[core] -= alloc_amount;
@@ -53,10 +94,10 @@ ScheduleDecision UEDF::schedule(const SimModel& model) {
     }
 
     // schedule
-    std::vector<int> task_core(model.task_set.size(), -2); // -2 if not active, -1 if not scheduled
-    std::vector<int> core_budget_index(model.cores, -1);
-    for (const Job& job : model.active_jobs)
-        task_core[job.task_id] = -1;
+    std::pmr::vector<int> task_core(model.task_set.size(), -2, &model.scratch); // -2 if not active, -1 if not scheduled
+    std::pmr::vector<int> core_budget_index(model.cores, -1, &model.scratch);
+    for (JobView job : model.active_jobs)
+        task_core[job.task_id()] = -1;
     for (int core = 0; core < model.cores; ++core) {
         for (int budget_index = 0; budget_index < core_budgets[core].size(); ++budget_index) {
             auto& budget = core_budgets[core][budget_index];
@@ -66,27 +107,26 @@ ScheduleDecision UEDF::schedule(const SimModel& model) {
             break;
         }
     }
-    std::vector<int> chosen_jobs;
-    for (int i = 0; i < model.active_jobs.size(); ++i) {
-        const Job& job = model.active_jobs[i];
-        if (task_core[job.task_id] != -1)
-            chosen_jobs.push_back(i);
-    }
+    std::pmr::vector<int> chosen_jobs(&model.scratch);
+    for (JobView job : model.active_jobs)
+        if (task_core[job.task_id()] != -1 && task_job[job.task_id()] == job.slot)
+            chosen_jobs.push_back(job.slot);
     assignToCores(model.active_jobs, sd.core_state, chosen_jobs);
-    sd.next_event = nextSchedEvent(model.task_set, model.active_jobs, model.time);
+
+    // budget exhaustion timers (timer id = core)
     for (int core = 0; core < model.cores; ++core) {
         int budget_index = core_budget_index[core];
-        if (budget_index == -1) continue;
-        sd.next_event = std::min(sd.next_event, model.time + core_budgets[core][budget_index].second);
+        if (budget_index == -1) events->clearTimer(core);
+        else events->setTimer(core, model.time + core_budgets[core][budget_index].second);
     }
+    sd.next_event = std::min(nextSchedEvent(model), model.events.nextTimer());
 
     // update budgets
-    Fraction delta_time = sd.next_event - model.time;
+    Time delta_time = sd.next_event - model.time;
     for (int core = 0; core < model.cores; ++core) {
         int budget_index = core_budget_index[core];
         if (budget_index == -1) continue;
         core_budgets[core][budget_index].second -= delta_time;
     }
 
-    return sd;
 }
\ No newline at end of file
@@ -0,0 +1,339 @@
+#ifndef SIM_LOOP_H
+#define SIM_LOOP_H
+
+#include "model.h"
+#include <algorithm>
+#include <chrono>
+
+// the simulation loop, in a header so SimModel::run_observed can be used with any observer list
+
+// forwards each hook to a list of observers through their virtual hooks (SimModel::observers)
+struct RuntimeObservers : public SimObserver {
+    const std::vector<SimObserver*>& list;
+    RuntimeObservers(const std::vector<SimObserver*>& list) : list(list) {}
+
+    void onRelease(const SimModel& model, JobView job) override {
+        for (SimObserver* observer : list) observer->onRelease(model, job);
+    }
+    void onSwitch(const SimModel& model, int core, int slot) override {
+        for (SimObserver* observer : list) observer->onSwitch(model, core, slot);
+    }
+    void onDispatch(const SimModel& model, JobView job, int core) override {
+        for (SimObserver* observer : list) observer->onDispatch(model, job, core);
+    }
+    void onPreempt(const SimModel& model, JobView job, int core) override {
+        for (SimObserver* observer : list) observer->onPreempt(model, job, core);
+    }
+    void onMigrate(const SimModel& model, JobView job, int from, int to) override {
+        for (SimObserver* observer : list) observer->onMigrate(model, job, from, to);
+    }
+    void onExec(const SimModel& model, const ExecBlock& block) override {
+        for (SimObserver* observer : list) observer->onExec(model, block);
+    }
+    void onComplete(const SimModel& model, JobView job, Time time) override {
+        for (SimObserver* observer : list) observer->onComplete(model, job, time);
+    }
+    void onMiss(const SimModel& model, JobView job) override {
+        for (SimObserver* observer : list) observer->onMiss(model, job);
+    }
+};
+
+template<class... Observers>
+SimProgress SimModel::run_observed(const std::function<bool(const SimModel&)>& done, const SimLimits& limits, Observers&... list) {
+    SimProgress progress;
+    JobSet& jobs = active_jobs;
+    bool incremental = use_incremental && scheduler->incremental();
+    bool overheads = overhead_model != nullptr;
+    bool scaled = dvfs_policy != nullptr || std::any_of(core_speed.begin(), core_speed.end(), [](Fraction speed) { return speed != 1; });
+    std::pmr::vector<int> order(&scratch);
+    std::pmr::vector<char> was_running(&scratch);
+    std::pmr::vector<int> completed(&scratch);
+    std::pmr::vector<int> late(&scratch);
+    std::pmr::vector<int> prev_state(&scratch);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [start]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    bool timed = limits.max_seconds != std::numeric_limits<double>::infinity() || limits.progress;
+    double next_report = limits.progress_interval;
+    while (true) {
+        // stop before the next decision if finished or out of budget
+        if (halted()) {
+            progress.stop = SimProgress::HALTED;
+            break;
+        }
+        if (done(*this)) {
+            progress.stop = SimProgress::FINISHED;
+            break;
+        }
+        if (progress.events >= limits.max_events) {
+            progress.stop = SimProgress::EVENT_LIMIT;
+            break;
+        }
+        if (limits.cancel && limits.cancel->load(std::memory_order_relaxed)) {
+            progress.stop = SimProgress::CANCELLED;
+            break;
+        }
+        if (timed) {
+            progress.seconds = elapsed();
+            if (progress.seconds >= limits.max_seconds) {
+                progress.stop = SimProgress::TIME_LIMIT;
+                break;
+            }
+            if (limits.progress && progress.seconds >= next_report) {
+                limits.progress(progress);
+                next_report = progress.seconds + limits.progress_interval;
+            }
+        }
+        // keep times small by moving origin forward
+        if (rebase_period > 0 && time >= rebase_period)
+            rebase(rebase_period * floorDiv(time, rebase_period));
+
+        // handle job releases by time
+        while (events.nextRelease() <= time) {
+            int tid = events.nextReleaseTask();
+            Task& task = task_set[tid];
+            Time release = events.nextRelease();
+            Job job = task.next_job(tid);
+            Time next_release = task.next_release;
+            if (release_model) {
+                job.release_time = release;
+                task.next_release += release_model->slack(task, tid, release_rng);
+                assert(task.next_release >= time);
+                next_release = task.next_release + release_model->jitter(task, tid, release_rng);
+            }
+            if (exec_model) {
+                job.work = exec_model->execTime(task, tid, exec_rng);
+                assert(job.work > 0 && job.work <= job.exec_time);
+            }
+            job.event_id = events.addDeadline(job.deadline);
+            int slot = jobs.add(job);
+            events.setRelease(tid, next_release);
+            (list.Observers::onRelease(*this, jobs[slot]), ...);
+            if (incremental) {
+                delta.clear();
+                scheduler->on_release(*this, slot, delta);
+                apply(delta);
+            }
+        }
+
+        // fire scheduler timers (schedule() reads its own timers, so only for the incremental interface)
+        while (incremental && events.nextTimer() <= time) {
+            int id = events.nextTimerId();
+            events.clearTimer(id);
+            delta.clear();
+            scheduler->on_timer(*this, id, delta);
+            apply(delta);
+        }
+
+        // order jobs by executing first then preemptive then fresh (jobs stay in their slots)
+        // stable so ties keep breaking the same way, through a scratch copy of the order
+        int next_executing = 0;
+        int next_preempted = 0;
+        int next_unexecuted = 0;
+        for (int i : jobs.order) {
+            if (jobs.running[i]) ++next_preempted;
+            else if (jobs.core[i] != -1) ++next_unexecuted;
+        }
+        next_unexecuted += next_preempted;
+        order.resize(jobs.size());
+        for (int i : jobs.order) {
+            if (jobs.running[i]) order[next_executing++] = i;
+            else if (jobs.core[i] != -1) order[next_preempted++] = i;
+            else order[next_unexecuted++] = i;
+        }
+        std::copy(order.begin(), order.end(), jobs.order.begin());
+
+        // stop once the state repeats
+        if (detect_steady_state && !release_model && !exec_model && (time >= next_fingerprint || (jobs.empty() && !idle_fingerprinted))) {
+            if (time >= next_fingerprint) {
+                // the grid starts at the first fingerprint, detection may be switched on mid run (Experiment::sched)
+                Time period = hyperperiod(task_set);
+                Time anchor = fingerprints ? next_fingerprint : time;
+                next_fingerprint = period > 0 ? anchor + period * (floorDiv(time - anchor, period) + 1) : TIME_MAX;
+                idle_fingerprinted = false;
+            } else idle_fingerprinted = true;
+            std::vector<Time> state;
+            fingerprint(state);
+            if (!fingerprints)
+                fingerprints = std::make_shared<std::map<std::vector<Time>, Time>>();
+            auto seen = fingerprints->find(state);
+            if (seen != fingerprints->end()) {
+                steady_period = origin + time - seen->second;
+                continue;
+            }
+            if (fingerprints.use_count() > 1)
+                fingerprints = std::make_shared<std::map<std::vector<Time>, Time>>(*fingerprints);
+            fingerprints->emplace(state, origin + time);
+        }
+
+        // schedule (incremental changes are already in core_state)
+        ScheduleDecision& sd = decision;
+        if (incremental) {
+            if (verify_incremental) {
+                ScheduleDecision check(cores);
+                scheduler->schedule(*this, check);
+                assert(scheduler->sameDecision(*this, check.core_state, core_state));
+            }
+            sd.next_event = std::min({events.nextRelease(), events.nextDeadline(), events.nextTimer()});
+            sd.core_state = core_state;
+        } else {
+            sd.reset(cores);
+            scheduler->schedule(*this, sd);
+        }
+        assert(sd.core_state.size() == cores);
+        prev_state.assign(cores, -1);
+        for (int i : jobs.order)
+            if (jobs.running[i]) prev_state[jobs.core[i]] = i;
+        was_running.assign(jobs.running.begin(), jobs.running.end());
+        std::fill(jobs.running.begin(), jobs.running.end(), false);
+        for (int c = 0; c < sd.core_state.size(); ++c) {
+            int i = sd.core_state[c];
+            if (prev_state[c] != i) {
+                ++cswitch_count;
+                (list.Observers::onSwitch(*this, c, i), ...);
+            }
+            if (i != -1) {
+                if (overheads && prev_state[c] != i)
+                    jobs.overhead[i] = overhead_model->switchCost(*this, jobs[i], c);
+                if (jobs.core[i] != -1 && jobs.core[i] != c) {
+                    ++jobs.migration_count[i];
+                    (list.Observers::onMigrate(*this, jobs[i], jobs.core[i], c), ...);
+                }
+                jobs.core[i] = c;
+                jobs.running[i] = true;
+                if (prev_state[c] != i)
+                    (list.Observers::onDispatch(*this, jobs[i], c), ...);
+            }
+        }
+        if constexpr (sizeof...(Observers) > 0) {
+            for (int c = 0; c < cores; ++c)
+                if (prev_state[c] != -1 && !jobs.running[prev_state[c]])
+                    (list.Observers::onPreempt(*this, jobs[prev_state[c]], c), ...);
+        }
+        core_state = sd.core_state;
+        if (dvfs_policy)
+            dvfs_policy->setSpeeds(*this, core_speed);
+        if (incremental || scaled || exec_model) {
+            // completions come after the overhead left on each core and at its speed (known once the jobs are dispatched)
+            // schedulers only know the WCET, so a job finishing early is found here too
+            for (int c = 0; c < cores; ++c) {
+                int i = sd.core_state[c];
+                if (i == -1) continue;
+                assert(core_speed[c] > 0);
+                Time completion = time + (scaled ? timeFor(jobs.work[i] - jobs.runtime[i], core_speed[c]) : jobs.work[i] - jobs.runtime[i]);
+                if (overheads) completion += jobs.overhead[i];
+                sd.next_event = std::min(sd.next_event, completion);
+            }
+        }
+        Time delta_time = sd.next_event - time;
+        assert(delta_time > 0);
+
+        // update exec blocks and buffer + handle job deadlines (and misses) + handle preemption counting
+        int live = 0;
+        completed.clear();
+        late.clear();
+        for (int k = 0; k < jobs.size(); ++k) {
+            int i = jobs.order[k];
+            if (jobs.running[i]) {
+                Time start = time;
+                if (overheads && jobs.overhead[i] > 0) {
+                    // switching overhead comes first, the job runs in what is left
+                    Time spent = std::min(jobs.overhead[i], delta_time);
+                    jobs.overhead[i] -= spent;
+                    start += spent;
+                    if (ebs_active || sizeof...(Observers) > 0) {
+                        ExecBlock block(jobs.task_id[i], jobs.job_id[i], jobs.core[i], origin + time, origin + start, ExecBlock::OVERHEAD);
+                        if (ebs_active)
+                            ebs.add_block(block);
+                        (list.Observers::onExec(*this, block), ...);
+                    }
+                }
+                // work done (block_runtime) and when the job stops (end)
+                Time block_runtime = std::min(jobs.work[i] - jobs.runtime[i], sd.next_event - start);
+                Time end = start + block_runtime;
+                if (scaled && core_speed[jobs.core[i]] != 1) {
+                    Fraction speed = core_speed[jobs.core[i]];
+                    Time finish = start + timeFor(jobs.work[i] - jobs.runtime[i], speed);
+                    end = std::min(finish, sd.next_event);
+                    // the rounded up finish always completes the job
+                    block_runtime = end == finish ? jobs.work[i] - jobs.runtime[i] : std::min(jobs.work[i] - jobs.runtime[i], workIn(end - start, speed));
+                }
+                jobs.runtime[i] += block_runtime;
+                if ((ebs_active || sizeof...(Observers) > 0) && end > start) {
+                    ExecBlock block(jobs[i], start, end, origin);
+                    if (ebs_active)
+                        ebs.add_block(block);
+                    (list.Observers::onExec(*this, block), ...);
+                }
+                if (jobs.runtime[i] == jobs.work[i]) {
+                    core_state[jobs.core[i]] = -1;
+                    if (jobs.event_id[i] != -1)
+                        events.removeDeadline(jobs.event_id[i]);
+                    Job job = jobs.get(i);
+                    Fraction response_time = toExact(end - job.release_time);
+                    stats.add(job, (double)response_time.getNum() / response_time.getDen());
+                    Fraction lateness = toExact(end - job.deadline);
+                    task_stats[job.task_id].complete((double)lateness.getNum() / lateness.getDen());
+                    if (keep_finished_jobs) {
+                        job.release_time += origin;
+                        job.deadline += origin;
+                        finished_jobs.push_back(job);
+                    }
+                    (list.Observers::onComplete(*this, jobs[i], end), ...);
+                    completed.push_back(i);
+                    continue;
+                } else jobs.preempt_count[i] += !was_running[i];
+            } else if (overheads) {
+                jobs.overhead[i] = 0; // overhead left when the job lost its core is paid again on its next dispatch
+            }
+            if (jobs.event_id[i] != -1 && jobs.deadline[i] <= sd.next_event) {
+                missed = i;
+                (list.Observers::onMiss(*this, jobs[i]), ...);
+                if (miss_policy != ABORT) {
+                    // the deadline event is spent, a late job's deadline stays in the past
+                    events.removeDeadline(jobs.event_id[i]);
+                    jobs.event_id[i] = -1;
+                    late.push_back(i);
+                    task_stats[jobs.task_id[i]].miss();
+                }
+                if (miss_policy == DROP) {
+                    if (jobs.running[i])
+                        core_state[jobs.core[i]] = -1;
+                    task_stats[jobs.task_id[i]].drop();
+                    continue;
+                }
+            }
+            jobs.order[live++] = i;
+        }
+        jobs.order.resize(live);
+        time = sd.next_event;
+
+        // free completed and dropped slots once every job has its new runtime
+        // late jobs go first, waiting ones before running ones, so a freed core is never handed to a job about to be dropped
+        for (int running = 0; running < 2; ++running) {
+            for (int i : late) {
+                if (jobs.running[i] != running) continue;
+                if (incremental) {
+                    delta.clear();
+                    scheduler->on_deadline(*this, i, delta);
+                    apply(delta);
+                }
+                if (miss_policy == DROP)
+                    jobs.remove(i);
+            }
+        }
+        for (int i : completed) {
+            if (incremental) {
+                delta.clear();
+                scheduler->on_complete(*this, i, delta);
+                apply(delta);
+            }
+            jobs.remove(i);
+        }
+        ++event_count;
+        ++progress.events;
+    }
+    progress.seconds = elapsed();
+    return progress;
+}
+
+#endif
\ No newline at end of file
@@ -8,7 +8,7 @@
 
 std::default_random_engine TaskSetGenerator::gen;
 
-TaskSet TaskSetGenerator::genModifiedKraemer(int precision, Fraction util, int task_count, int min_period, int max_period) {
+ExactTaskSet TaskSetGenerator::genModifiedKraemer(int precision, Fraction util, int task_count, int min_period, int max_period) {
     // input validation
     auto frac_valid = [precision](Fraction frac) {
         return (frac * precision).isInt();
@@ -36,7 +36,7 @@ TaskSet TaskSetGenerator::genModifiedKraemer(int precision, Fraction util, int t
     }
 
     // construct task set
-    TaskSet task_set;
+    ExactTaskSet task_set;
     task_set.reserve(task_count);
     for (int scaled_util : scaled_utils) {
         Fraction task_util = Fraction(scaled_util, precision);
@@ -58,7 +58,7 @@ std::vector<double> uunifast(std::default_random_engine& gen, double u, int n) {
     return s;
 }
 
-TaskSet TaskSetGenerator::genUUniFastDiscard(int precision, Fraction util, int task_count, int min_period, int max_period) {
+ExactTaskSet TaskSetGenerator::genUUniFastDiscard(int precision, Fraction util, int task_count, int min_period, int max_period) {
     // input validation
     auto frac_valid = [precision](Fraction frac) {
         return (frac * precision).isInt();
@@ -101,7 +101,7 @@ TaskSet TaskSetGenerator::genUUniFastDiscard(int precision, Fraction util, int t
 
     // construct task set
     std::uniform_int_distribution<int> period_urand(min_period, max_period);
-    TaskSet task_set;
+    ExactTaskSet task_set;
     task_set.reserve(task_count);
     for (int scaled_util : scaled_utils) {
         Fraction task_util = Fraction(scaled_util, precision);
@@ -111,4 +111,34 @@ TaskSet TaskSetGenerator::genUUniFastDiscard(int precision, Fraction util, int t
     std::shuffle(task_set.begin(), task_set.end(), gen); // done to ensure bumps are sufficiently random
 
     return task_set;
+}
+
+Time UniformReleaseModel::slack(const Task& task, int task_id, std::mt19937_64& rng) const {
+    std::uniform_int_distribution<int> step_urand(0, steps);
+    return scaleTime(task.period, max_slack * Fraction(step_urand(rng), steps));
+}
+
+Time UniformReleaseModel::jitter(const Task& task, int task_id, std::mt19937_64& rng) const {
+    std::uniform_int_distribution<int> step_urand(0, steps);
+    return scaleTime(task.period, max_jitter * Fraction(step_urand(rng), steps));
+}
+
+Time UniformExecModel::execTime(const Task& task, int task_id, std::mt19937_64& rng) const {
+    std::uniform_int_distribution<int> step_urand(0, steps);
+    Time exec_time = scaleTime(task.exec_time, min_ratio + (1 - min_ratio) * Fraction(step_urand(rng), steps));
+
+    // keep at least one step (one tick with MARISA_TICK_TIME) so the job still runs
+    return std::max(exec_time, EXACT_TIME ? scaleTime(task.exec_time, Fraction(1, steps)) : Time(1));
+}
+
+Time CacheOverheadModel::switchCost(const SimModel& model, JobView job, int core) const {
+    Fraction cost = dispatch;
+    if (job.core() != -1) {
+        // resuming, the working set was evicted while the job was preempted
+        if (job.task_id() < working_set.size())
+            cost += reload * working_set[job.task_id()];
+        if (job.core() != core)
+            cost += migration;
+    }
+    return model.toTime(cost);
 }
\ No newline at end of file
@@ -14,12 +14,43 @@ struct TaskSetGenerator {
     // if input invalid, returns an empty set
 
     // uses modified Kraemer Algorithm defined here https://www.cs.cmu.edu/~nasmith/papers/smith+tromble.tr04.pdf
-    static TaskSet genModifiedKraemer(int precision, Fraction util, int task_count, int min_period, int max_period);
+    static ExactTaskSet genModifiedKraemer(int precision, Fraction util, int task_count, int min_period, int max_period);
 
     // uses UUniFast-Discard
-    static TaskSet genUUniFastDiscard(int precision, Fraction util, int task_count, int min_period, int max_period);
+    static ExactTaskSet genUUniFastDiscard(int precision, Fraction util, int task_count, int min_period, int max_period);
 
     // both genURPartition and genUUniFastDiscard should be indistinguishable, but genUUniFastDiscard is the formalized method
 };
 
+// sporadic releases with slack uniform in [0, max_slack] and jitter uniform in [0, max_jitter], both as fractions of the period
+// draws are whole multiples of 1/steps of the maximum so they stay exact
+struct UniformReleaseModel : public ReleaseModel {
+    Fraction max_slack;
+    Fraction max_jitter; // at most 1 so a job is ready before the next one arrives
+    int steps;
+    UniformReleaseModel(Fraction max_slack, Fraction max_jitter, int steps = 1000) : max_slack(max_slack), max_jitter(max_jitter), steps(steps) {}
+    Time slack(const Task& task, int task_id, std::mt19937_64& rng) const override;
+    Time jitter(const Task& task, int task_id, std::mt19937_64& rng) const override;
+};
+
+// execution time uniform in [min_ratio, 1] of the WCET, drawn in steps of 1/steps of the range
+struct UniformExecModel : public ExecModel {
+    Fraction min_ratio;
+    int steps;
+    UniformExecModel(Fraction min_ratio, int steps = 1000) : min_ratio(min_ratio), steps(steps) {}
+    Time execTime(const Task& task, int task_id, std::mt19937_64& rng) const override;
+};
+
+// fixed switching costs plus a cache-related preemption delay, in task set time units (rounded up to a tick with MARISA_TICK_TIME)
+// every dispatch costs dispatch, a job resuming after a preemption reloads its task's working set at reload per unit,
+// and one resuming on another core pays migration on top
+struct CacheOverheadModel : public OverheadModel {
+    Fraction dispatch;
+    Fraction migration;
+    Fraction reload;
+    std::vector<int> working_set; // by task id (none for tasks past the end), e.g. in cache lines
+    CacheOverheadModel(Fraction dispatch, Fraction migration = 0, Fraction reload = 0, std::vector<int> working_set = {}) : dispatch(dispatch), migration(migration), reload(reload), working_set(working_set) {}
+    Time switchCost(const SimModel& model, JobView job, int core) const override;
+};
+
 #endif
\ No newline at end of file
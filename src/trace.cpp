@@ -0,0 +1,585 @@
+#include "trace.h"
+
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TraceWriter::TraceWriter(const std::string& path, size_t buffer_size, int segment_records) : out(path, std::ios::binary | std::ios::trunc), buffer_size(buffer_size), segment_records(segment_records) {
+    assert(segment_records > 0);
+    buffer.reserve(buffer_size);
+    buffer.insert(buffer.end(), Trace::MAGIC, Trace::MAGIC + 4);
+    putVarint(Trace::VERSION);
+}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+void TraceWriter::putVarint(unsigned long long value) {
+    while (value >= 0x80) {
+        buffer.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((unsigned char)value);
+}
+
+// zigzag keeps small negative values short, the low bit is the denominator flag
+void TraceWriter::putValue(long long value) {
+    unsigned long long zigzag = ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+    putVarint(zigzag << 1);
+}
+
+void TraceWriter::putValue(Fraction value) {
+    long long num = value.getNum(), den = value.getDen();
+    unsigned long long zigzag = ((unsigned long long)num << 1) ^ (unsigned long long)(num >> 63);
+    putVarint(zigzag << 1 | (den != 1));
+    if (den != 1)
+        putVarint(den);
+}
+
+void TraceWriter::putJob(int task_id, int job_id) {
+    assert(task_id < (int)last_job.size()); // run() comes first
+    putValue((long long)(job_id - last_job[task_id]));
+    last_job[task_id] = job_id;
+}
+
+void TraceWriter::putTag(Trace::Kind kind, int extra) {
+    if (buffer.size() >= buffer_size)
+        flush();
+    putVarint(kind | extra << 3);
+    ++records;
+}
+
+void TraceWriter::putRecord(Trace::Kind kind, Time time, int extra) {
+    assert(!index.empty()); // run() comes first
+    Time value = time * ratio;
+    if (segment_left-- == 0) {
+        segment_left = segment_records - 1;
+        index.back().segments.push_back({written + buffer.size(), value, value});
+        putTag(Trace::SYNC);
+        putValue(value);
+        last_time = value;
+        std::fill(last_job.begin(), last_job.end(), -1);
+    }
+    putTag(kind, extra);
+    putValue(value - last_time);
+    last_time = value;
+    extendSegment(value);
+}
+
+void TraceWriter::extendSegment(Time end) {
+    Segment& segment = index.back().segments.back();
+    segment.start = std::min(segment.start, end);
+    segment.end = std::max(segment.end, end);
+}
+
+void TraceWriter::run(const SimModel& model, const ExactTaskSet& task_set) {
+    // exact times are scaled by the lcm of the task set denominators so most values are whole numbers
+    scale = model.time_scale;
+    auto scaleBy = [&](Fraction value) {
+        long long den = value.getDen();
+        long long factor = den / std::gcd(scale, den);
+        if (scale > LLONG_MAX / factor) return false;
+        scale *= factor;
+        return true;
+    };
+    if (EXACT_TIME) {
+        bool fits = true;
+        for (const auto& task : task_set)
+            fits = fits && scaleBy(task.phase) && scaleBy(task.period) && scaleBy(task.exec_time) && scaleBy(task.relative_deadline);
+        if (!fits) scale = 1;
+    }
+    assert(scale % model.time_scale == 0);
+    ratio = scale / model.time_scale;
+    index.push_back({written + buffer.size(), scale, {}});
+    putTag(Trace::RUN);
+    putVarint(model.cores);
+    putVarint(scale);
+    putVarint(model.miss_policy);
+    putVarint(task_set.size());
+    for (const auto& task : task_set)
+        for (Fraction value : {task.phase, task.period, task.exec_time, task.relative_deadline})
+            putValue(value * scale);
+    last_time = 0;
+    last_job.assign(task_set.size(), -1);
+    segment_left = 0;
+}
+
+void TraceWriter::release(JobView job, Time origin) {
+    putRecord(Trace::RELEASE, origin + job.release_time());
+    putVarint(job.task_id());
+    putJob(job.task_id(), job.job_id());
+    putValue((job.deadline() - job.release_time()) * ratio);
+    putValue(job.exec_time() * ratio);
+}
+
+void TraceWriter::miss(JobView job, Time origin) {
+    putRecord(Trace::MISS, origin + job.deadline());
+    putVarint(job.task_id());
+    putJob(job.task_id(), job.job_id());
+}
+
+void TraceWriter::block(const ExecBlock& block) {
+    putRecord(Trace::BLOCK, block.start, block.endState);
+    Time duration = (block.end - block.start) * ratio;
+    putValue(duration);
+    putVarint(block.task_id);
+    putJob(block.task_id, block.job_id);
+    putVarint(block.core);
+    extendSegment(last_time + duration);
+}
+
+void TraceWriter::cswitch(Time time, int core, int task_id, int job_id) {
+    putRecord(Trace::SWITCH, time);
+    putVarint(core);
+    putVarint(task_id + 1);
+    if (task_id != -1)
+        putJob(task_id, job_id);
+}
+
+void TraceWriter::onReset(const SimModel& model, const ExactTaskSet& task_set) {
+    run(model, task_set);
+}
+
+void TraceWriter::onRelease(const SimModel& model, JobView job) {
+    release(job, model.origin);
+}
+
+void TraceWriter::onSwitch(const SimModel& model, int core, int slot) {
+    cswitch(model.origin + model.time, core, slot == -1 ? -1 : model.active_jobs.task_id[slot], slot == -1 ? -1 : model.active_jobs.job_id[slot]);
+}
+
+void TraceWriter::onExec(const SimModel&, const ExecBlock& block) {
+    this->block(block);
+}
+
+void TraceWriter::onMiss(const SimModel& model, JobView job) {
+    miss(job, model.origin);
+}
+
+void TraceWriter::flush() {
+    out.write((const char*)buffer.data(), buffer.size());
+    out.flush();
+    written += buffer.size();
+    buffer.clear();
+}
+
+void TraceWriter::close() {
+    if (!out.is_open()) return;
+    size_t offset = written + buffer.size();
+    putVarint(Trace::INDEX);
+    putVarint(index.size());
+    for (const Run& run : index) {
+        putVarint(run.offset);
+        putVarint(run.scale);
+        putVarint(run.segments.size());
+        size_t last_offset = run.offset;
+        Time last_start = 0;
+        for (const Segment& segment : run.segments) {
+            putVarint(segment.offset - last_offset);
+            putValue(segment.start - last_start);
+            putValue(segment.end - segment.start);
+            last_offset = segment.offset;
+            last_start = segment.start;
+        }
+    }
+    for (int i = 0; i < 8; ++i)
+        buffer.push_back((unsigned char)(offset >> (i * 8)));
+    flush();
+    out.close();
+    index.clear();
+}
+
+static bool readVarint(const unsigned char*& data, const unsigned char* end, unsigned long long& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data == end) return false;
+        unsigned char byte = *data++;
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static long long unzigzag(unsigned long long value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+// value in trace units
+static bool readValue(const unsigned char*& data, const unsigned char* end, Fraction& value) {
+    unsigned long long bits, den = 1;
+    if (!readVarint(data, end, bits)) return false;
+    if ((bits & 1) && (!readVarint(data, end, den) || den == 0 || den > LLONG_MAX)) return false;
+    value = Fraction(unzigzag(bits >> 1), (long long)den);
+    return true;
+}
+
+TraceReader::TraceReader(const unsigned char* data, size_t size) : begin(data), data(data), end(data + size) {
+    unsigned long long value;
+    if (size >= 4 && std::memcmp(data, Trace::MAGIC, 4) == 0) {
+        this->data += 4;
+        if (getVarint(value))
+            version = value;
+    }
+}
+
+void TraceReader::seek(size_t offset) {
+    data = begin + std::min(offset, (size_t)(end - begin));
+}
+
+bool TraceReader::getVarint(unsigned long long& value) {
+    return readVarint(data, end, value);
+}
+
+bool TraceReader::getValue(Fraction& value) {
+    if (!readValue(data, end, value)) return false;
+    value /= scale;
+    return true;
+}
+
+bool TraceReader::getJob(int task_id, int& job_id) {
+    unsigned long long bits;
+    if (!getVarint(bits) || (bits & 1)) return false;
+    job_id = last_job[task_id] += (int)unzigzag(bits >> 1);
+    return true;
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    if (!valid()) return false;
+    unsigned long long tag, value;
+    if (!getVarint(tag)) return false;
+    record = TraceRecord();
+    record.kind = (Trace::Kind)(tag & 7);
+    if (record.kind == Trace::RUN) {
+        unsigned long long run_scale, policy, count;
+        if (!getVarint(value) || !getVarint(run_scale) || !getVarint(policy) || !getVarint(count)) return false;
+        if (value > INT_MAX || run_scale == 0 || run_scale > LLONG_MAX || policy > (unsigned long long)SimModel::DROP || count > (size_t)(end - data)) return false;
+        cores = value;
+        scale = run_scale;
+        miss_policy = (SimModel::MissPolicy)policy;
+        task_set.assign(count, BasicTask<Fraction>());
+        for (auto& task : task_set)
+            for (Fraction* field : {&task.phase, &task.period, &task.exec_time, &task.relative_deadline})
+                if (!getValue(*field)) return false;
+        for (auto& task : task_set)
+            task.next_release = task.phase;
+        last_time = 0;
+        last_job.assign(count, -1);
+        return true;
+    }
+
+    if (record.kind == Trace::SYNC) {
+        if (!getValue(record.time)) return false;
+        last_time = record.time;
+        std::fill(last_job.begin(), last_job.end(), -1);
+        return true;
+    }
+
+    Fraction delta;
+    if (!getValue(delta)) return false;
+    record.time = last_time += delta;
+    auto getTask = [&]() {
+        if (!getVarint(value) || value >= task_set.size()) return false;
+        record.task_id = value;
+        return true;
+    };
+    auto getCore = [&]() {
+        if (!getVarint(value) || value >= (unsigned long long)cores) return false;
+        record.core = value;
+        return true;
+    };
+    switch (record.kind) {
+    case Trace::RELEASE:
+        if (!getTask() || !getJob(record.task_id, record.job_id) || !getValue(record.deadline) || !getValue(record.exec_time)) return false;
+        record.deadline += record.time;
+        return true;
+    case Trace::BLOCK:
+        if ((tag >> 3) > (unsigned long long)ExecBlock::OVERHEAD) return false;
+        record.end_state = (ExecBlock::EndState)(tag >> 3);
+        return getValue(record.duration) && getTask() && getJob(record.task_id, record.job_id) && getCore();
+    case Trace::MISS:
+        return getTask() && getJob(record.task_id, record.job_id);
+    case Trace::SWITCH:
+        if (!getCore() || !getVarint(value) || value > task_set.size()) return false;
+        record.task_id = (int)value - 1;
+        return record.task_id == -1 || getJob(record.task_id, record.job_id);
+    default:
+        return false;
+    }
+}
+
+static double toDouble(Fraction value) {
+    return (double)value.getNum() / value.getDen();
+}
+
+TraceFile::~TraceFile() {
+    close();
+}
+
+bool TraceFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    file = handle;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0) {
+        close();
+        return false;
+    }
+    size = file_size.QuadPart;
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    file = ::open(path.c_str(), O_RDONLY);
+    if (file == -1) return false;
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close();
+        return false;
+    }
+    size = info.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (map != MAP_FAILED) {
+        data = (const unsigned char*)map;
+        madvise(map, size, MADV_RANDOM); // segments are paged in as they come on screen
+    }
+#endif
+    if (!data || !TraceReader(data, size).valid()) {
+        close();
+        return false;
+    }
+    if (!readIndex())
+        scanIndex();
+    return true;
+}
+
+void TraceFile::close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    mapping = file = nullptr;
+#else
+    if (data) munmap((void*)data, size);
+    if (file != -1) ::close(file);
+    file = -1;
+#endif
+    data = nullptr;
+    size = 0;
+    runs.clear();
+}
+
+void TraceFile::finishRun(Run& run) {
+    for (size_t i = 0; i < run.segments.size(); ++i)
+        run.segments[i].end_offset = i + 1 < run.segments.size() ? run.segments[i + 1].offset : run.end_offset;
+    run.end_before.resize(run.segments.size());
+    run.start_after.resize(run.segments.size());
+    for (size_t i = 0; i < run.segments.size(); ++i)
+        run.end_before[i] = std::max(run.segments[i].end, i > 0 ? run.end_before[i - 1] : run.segments[i].end);
+    for (size_t i = run.segments.size(); i-- > 0;)
+        run.start_after[i] = std::min(run.segments[i].start, i + 1 < run.segments.size() ? run.start_after[i + 1] : run.segments[i].start);
+}
+
+bool TraceFile::readIndex() {
+    if (size < 8) return false;
+    size_t offset = 0;
+    for (int i = 0; i < 8; ++i)
+        offset |= (size_t)data[size - 8 + i] << (i * 8);
+    if (offset >= size - 8) return false;
+    const unsigned char* at = data + offset;
+    const unsigned char* end = data + size - 8;
+    unsigned long long tag, run_count;
+    if (!readVarint(at, end, tag) || tag != (unsigned long long)Trace::INDEX || !readVarint(at, end, run_count) || run_count > size) return false;
+    std::vector<Run> index(run_count);
+    for (Run& run : index) {
+        unsigned long long run_offset, scale, segment_count, segment_offset;
+        if (!readVarint(at, end, run_offset) || !readVarint(at, end, scale) || !readVarint(at, end, segment_count)) return false;
+        if (run_offset >= offset || scale == 0 || scale > LLONG_MAX || segment_count > size) return false;
+        run.offset = run_offset;
+        run.segments.resize(segment_count);
+        size_t last_offset = run.offset;
+        Fraction last_start = 0;
+        for (Segment& segment : run.segments) {
+            Fraction start, length;
+            if (!readVarint(at, end, segment_offset) || !readValue(at, end, start) || !readValue(at, end, length)) return false;
+            segment.offset = last_offset += segment_offset;
+            last_start += start;
+            if (segment.offset >= offset) return false;
+            segment.start = toDouble(last_start / (long long)scale);
+            segment.end = toDouble((last_start + length) / (long long)scale);
+        }
+    }
+    if (at != end) return false;
+
+    // run headers come from the runs themselves
+    for (size_t i = 0; i < index.size(); ++i) {
+        Run& run = index[i];
+        run.end_offset = i + 1 < index.size() ? index[i + 1].offset : offset;
+        TraceReader reader(data, size);
+        TraceRecord record;
+        reader.seek(run.offset);
+        if (!reader.next(record) || record.kind != Trace::RUN) return false;
+        run.cores = reader.cores;
+        run.miss_policy = reader.miss_policy;
+        run.task_set = reader.task_set;
+        finishRun(run);
+    }
+    runs = std::move(index);
+    return true;
+}
+
+void TraceFile::scanIndex() {
+    TraceReader reader(data, size);
+    TraceRecord record;
+    while (true) {
+        size_t offset = reader.offset();
+        if (!reader.next(record)) break;
+        if (record.kind == Trace::RUN) {
+            if (!runs.empty()) {
+                runs.back().end_offset = offset;
+                finishRun(runs.back());
+            }
+            runs.emplace_back();
+            runs.back().offset = offset;
+            runs.back().cores = reader.cores;
+            runs.back().miss_policy = reader.miss_policy;
+            runs.back().task_set = reader.task_set;
+            continue;
+        }
+        if (runs.empty()) continue;
+        std::vector<Segment>& segments = runs.back().segments;
+        double time = toDouble(record.time);
+        if (record.kind == Trace::SYNC)
+            segments.push_back({offset, 0, time, time});
+        else if (!segments.empty()) {
+            double end = record.kind == Trace::BLOCK ? toDouble(record.time + record.duration) : time;
+            segments.back().start = std::min(segments.back().start, time);
+            segments.back().end = std::max(segments.back().end, end);
+        }
+    }
+    if (!runs.empty()) {
+        runs.back().end_offset = reader.offset();
+        finishRun(runs.back());
+    }
+}
+
+std::pair<int, int> TraceFile::segmentRange(int run, double left, double right) const {
+    const Run& r = runs[run];
+    int first = std::lower_bound(r.end_before.begin(), r.end_before.end(), left) - r.end_before.begin();
+    int last = std::upper_bound(r.start_after.begin(), r.start_after.end(), right) - r.start_after.begin() - 1;
+    return {first, last};
+}
+
+void TraceFile::segmentBlocks(int run, int segment, long long time_scale, std::vector<ExecBlock>& blocks) const {
+    TraceReader reader(data, size);
+    TraceRecord record;
+    reader.seek(runs[run].offset);
+    if (!reader.next(record)) return;
+    const Segment& s = runs[run].segments[segment];
+    reader.seek(s.offset);
+    while (reader.offset() < s.end_offset && reader.next(record))
+        if (record.kind == Trace::BLOCK)
+            blocks.emplace_back(record.task_id, record.job_id, record.core, toTime(record.time, time_scale), toTime(record.time + record.duration, time_scale), record.end_state);
+}
+
+void exportChromeTrace(TraceReader& reader, std::ostream& out, double us_per_unit) {
+    TraceRecord record;
+    int pid = 0;
+    int task_tid = 0; // tid of task 0, cores come first
+    long long active = 0; // released jobs not finished
+    std::vector<std::pair<int, int>> on_core; // (task, job) on each core, task -1 if idle
+    long long ready = -1; // last counter value written
+    bool first = true;
+    auto ts = [us_per_unit](Fraction time) { return toDouble(time) * us_per_unit; };
+    auto event = [&]() -> std::ostream& {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        return out;
+    };
+    auto counter = [&](Fraction time) {
+        long long running = std::count_if(on_core.begin(), on_core.end(), [](const std::pair<int, int>& job) { return job.first != -1; });
+        if (active - running == ready) return;
+        ready = active - running;
+        event() << "{\"ph\":\"C\",\"name\":\"ready jobs\",\"pid\":" << pid << ",\"ts\":" << ts(time) << ",\"args\":{\"jobs\":" << ready << "}}";
+    };
+    auto slice = [&](int tid, const TraceRecord& block) {
+        event() << "{\"ph\":\"X\",\"name\":\"" << (block.end_state == ExecBlock::OVERHEAD ? "overhead " : "") << block.task_id + 1 << "," << block.job_id + 1 << "\",\"pid\":" << pid << ",\"tid\":" << tid
+                << ",\"ts\":" << ts(block.time) << ",\"dur\":" << ts(block.duration)
+                << ",\"args\":{\"task\":" << block.task_id + 1 << ",\"job\":" << block.job_id + 1 << ",\"core\":" << block.core + 1 << "}}";
+    };
+    auto instant = [&](const char* name, int task_id, int job_id, Fraction time) {
+        event() << "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"" << name << "\",\"pid\":" << pid << ",\"tid\":" << task_tid + task_id
+                << ",\"ts\":" << ts(time) << ",\"args\":{\"job\":" << job_id + 1 << "}}";
+    };
+    auto name = [&](const char* kind, int tid, const std::string& value) {
+        event() << "{\"ph\":\"M\",\"name\":\"" << kind << "\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"name\":\"" << value << "\"}}";
+        event() << "{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"sort_index\":" << tid << "}}";
+    };
+
+    std::streamsize precision = out.precision(15);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    while (reader.next(record)) {
+        switch (record.kind) {
+        case Trace::RUN:
+            ++pid;
+            task_tid = reader.cores + 1;
+            active = 0;
+            ready = -1;
+            on_core.assign(reader.cores, {-1, -1});
+            event() << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid << ",\"args\":{\"name\":\"run " << pid << "\"}}";
+            for (int c = 0; c < reader.cores; ++c)
+                name("thread_name", c + 1, "core " + std::to_string(c + 1));
+            for (int t = 0; t < (int)reader.task_set.size(); ++t)
+                name("thread_name", task_tid + t, "task " + std::to_string(t + 1));
+            break;
+        case Trace::SYNC:
+            break;
+        case Trace::RELEASE:
+            instant("release", record.task_id, record.job_id, record.time);
+            ++active;
+            counter(record.time);
+            break;
+        case Trace::BLOCK:
+            slice(record.core + 1, record);
+            slice(task_tid + record.task_id, record);
+            if (record.end_state == ExecBlock::COMPLETED) {
+                instant("complete", record.task_id, record.job_id, record.time + record.duration);
+                --active;
+                on_core[record.core] = {-1, -1};
+                counter(record.time + record.duration);
+            }
+            break;
+        case Trace::MISS:
+            instant("miss", record.task_id, record.job_id, record.time);
+            if (reader.miss_policy == SimModel::DROP) {
+                --active;
+                for (auto& job : on_core)
+                    if (job == std::make_pair(record.task_id, record.job_id))
+                        job = {-1, -1};
+                counter(record.time);
+            }
+            break;
+        case Trace::SWITCH:
+            on_core[record.core] = {record.task_id, record.job_id};
+            counter(record.time);
+            break;
+        default:
+            break;
+        }
+    }
+    out << "\n]}\n";
+    out.precision(precision);
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "model.h"
+#include <string>
+#include <vector>
+#include <fstream>
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// binary trace of simulation runs
+// a file is the magic "MRST" and a varint version, then records, then optionally an INDEX record and its offset as 8 little endian bytes
+// a record is a varint tag (kind in the low 3 bits, the exec block end state above) followed by its fields
+// values are zigzag varint numerators shifted left once, the low bit set if a varint denominator follows
+// times are in trace units (1/scale of a task set time unit), record times are stored as the difference from the previous record's time
+// job ids are stored as the difference from the previous job id of the same task since the last RUN or SYNC
+// RUN: cores, scale, miss policy, task count, then phase, period, exec time and relative deadline of each task (the time goes back to 0)
+// SYNC: absolute time, decoding can start here given the RUN before it (starts a segment of the run)
+// RELEASE: time, task, job, deadline - time, exec time
+// BLOCK: time, duration, task, job, core
+// MISS: time (the deadline), task, job
+// SWITCH: time, core, task + 1, job if task != -1 (the job that runs on core from time, task -1 if idle)
+// INDEX: run count, then for each run its offset, scale and segment count, then for each segment
+// its offset (difference from the previous segment's), earliest time (difference from the previous segment's) and latest end - earliest time
+struct Trace {
+    static constexpr char MAGIC[4] = {'M', 'R', 'S', 'T'};
+    static constexpr int VERSION = 2;
+    enum Kind { RUN, SYNC, RELEASE, BLOCK, MISS, SWITCH, INDEX };
+};
+
+// streams a trace to a file, records are collected in a buffer and written in batches
+// attach to SimModel::observers before reset, each reset starts a new run (call run directly when passed to SimModel::run_observed)
+// records are never rewritten, after SimModel::restore the new records follow the ones already written
+class TraceWriter : public SimObserver {
+    struct Segment {
+        size_t offset;
+        Time start, end; // in trace units
+    };
+    struct Run {
+        size_t offset;
+        long long scale;
+        std::vector<Segment> segments;
+    };
+
+    std::ofstream out;
+    std::vector<unsigned char> buffer;
+    size_t buffer_size;
+    size_t written = 0; // bytes already in the file
+    int segment_records; // records per segment
+    int segment_left = 0; // records until the next SYNC
+    long long scale = 1; // trace units per task set time unit
+    long long ratio = 1; // trace units per model time unit
+    Time last_time = 0; // in trace units
+    std::vector<int> last_job; // by task id
+    std::vector<Run> index;
+
+    void putVarint(unsigned long long value);
+    void putValue(long long value);
+    void putValue(Fraction value);
+    void putJob(int task_id, int job_id);
+    void putTag(Trace::Kind kind, int extra = 0);
+    void putRecord(Trace::Kind kind, Time time, int extra = 0); // tag and time (absolute model time), starting a segment if one is due
+    void extendSegment(Time end); // in trace units
+
+public:
+    long long records = 0;
+
+    // buffer_size bytes are collected before each write, a SYNC is written every segment_records records
+    TraceWriter(const std::string& path, size_t buffer_size = 1 << 16, int segment_records = 4096);
+    ~TraceWriter();
+
+    bool isOpen() const { return out.is_open(); }
+
+    // start a run of model (after its task set is loaded) from task_set
+    void run(const SimModel& model, const ExactTaskSet& task_set);
+
+    // jobs and times relative to origin
+    void release(JobView job, Time origin);
+    void miss(JobView job, Time origin);
+
+    // times are absolute
+    void block(const ExecBlock& block);
+    void cswitch(Time time, int core, int task_id, int job_id);
+
+    // write out buffered records
+    void flush();
+
+    // write the index and close the file (no more records can be written)
+    void close();
+
+    void onReset(const SimModel& model, const ExactTaskSet& task_set) override;
+    void onRelease(const SimModel& model, JobView job) override;
+    void onSwitch(const SimModel& model, int core, int slot) override;
+    void onExec(const SimModel& model, const ExecBlock& block) override;
+    void onMiss(const SimModel& model, JobView job) override;
+};
+
+// one decoded trace record, times in task set time units
+struct TraceRecord {
+    Trace::Kind kind = Trace::RUN;
+    Fraction time;
+    int task_id = -1;
+    int job_id = -1;
+    int core = -1;
+    Fraction duration; // BLOCK
+    ExecBlock::EndState end_state = ExecBlock::PREEMPTED; // BLOCK
+    Fraction deadline, exec_time; // RELEASE
+};
+
+// decodes a trace held in memory record by record
+// the header of the latest RUN is kept in cores, miss_policy and task_set
+class TraceReader {
+    const unsigned char* begin;
+    const unsigned char* data;
+    const unsigned char* end;
+    long long scale = 1;
+    Fraction last_time;
+    std::vector<int> last_job;
+
+    bool getVarint(unsigned long long& value);
+    bool getValue(Fraction& value); // in task set time units
+    bool getJob(int task_id, int& job_id);
+
+public:
+    int version = 0;
+    int cores = 0;
+    SimModel::MissPolicy miss_policy = SimModel::ABORT;
+    ExactTaskSet task_set;
+
+    TraceReader(const unsigned char* data, size_t size);
+
+    // false if the file header did not match
+    bool valid() const { return version == Trace::VERSION; }
+
+    // offset of the next record from the start of the file
+    size_t offset() const { return data - begin; }
+
+    // continue from a RUN or SYNC record at offset (a SYNC needs the RUN before it to have been read)
+    void seek(size_t offset);
+
+    // decode the next record, false at the end of the records or if one is malformed
+    bool next(TraceRecord& record);
+};
+
+// read-only memory mapped trace file with an index of where each run's segments are and when they happen
+// the index comes from the file's INDEX record, or from one pass over the records if it has none (the writer was not closed)
+class TraceFile {
+public:
+    struct Segment {
+        size_t offset, end_offset;
+        double start, end; // earliest record time and latest block end in task set time units
+    };
+    struct Run {
+        size_t offset, end_offset;
+        int cores;
+        SimModel::MissPolicy miss_policy;
+        ExactTaskSet task_set;
+        std::vector<Segment> segments;
+        std::vector<double> end_before; // latest end of segments up to each one
+        std::vector<double> start_after; // earliest start of segments from each one
+    };
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    bool readIndex();
+    void scanIndex();
+    void finishRun(Run& run);
+
+public:
+    std::vector<Run> runs;
+
+    TraceFile() {}
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
+    ~TraceFile();
+
+    // map path and load its index, false if it is not a trace
+    bool open(const std::string& path);
+    void close();
+
+    // reader over the whole file
+    TraceReader reader() const { return TraceReader(data, size); }
+
+    // segments of run that may hold records or blocks in [left, right] (first > second if none)
+    std::pair<int, int> segmentRange(int run, double left, double right) const;
+
+    // append the exec blocks recorded in a segment of run, times in model time units at time_scale
+    void segmentBlocks(int run, int segment, long long time_scale, std::vector<ExecBlock>& blocks) const;
+};
+
+// write the records read from reader as Chrome trace event JSON (for chrome://tracing and the Perfetto UI), one event at a time
+// each run is a process with a track per core and one per task: exec blocks are slices on both (overhead blocks named as such), releases, completions and misses
+// are instant events on the task track, and the number of released jobs not on a core is a counter
+// a task set time unit is shown as us_per_unit microseconds
+void exportChromeTrace(TraceReader& reader, std::ostream& out, double us_per_unit = 1000);
+
+#endif
\ No newline at end of file
@@ -33,6 +33,86 @@ bool Visualizer::isOpen() {
 }
 
 void Visualizer::update(SimModel& model, const MouseState& mouse, float fps) {
+    // handle new exec blocks
+    blocks.resize(model.task_set.size());
+    drained.resize(ExecBlockStorage::CHUNK_SIZE);
+    size_t count;
+    while ((count = model.ebs.drain(drained.data(), drained.size())) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            ExecBlock block = drained[i];
+            std::vector<ExecBlockView>& task_blocks = blocks[block.task_id];
+            if (!task_blocks.empty()) {
+                const ExecBlock& backBlock = task_blocks.back().block;
+                if (backBlock.end == block.start && backBlock.job_id == block.job_id && backBlock.core == block.core) {
+                    block.start = backBlock.start;
+                    task_blocks.pop_back();
+                }
+            }
+            blocks[block.task_id].emplace_back(block, 1.f / (float)model.time_scale);
+        }
+    }
+    draw(model.task_set, model.cores, model.time_scale, mouse, fps);
+}
+
+void Visualizer::replay(const TraceFile& trace, int run) {
+    this->trace = &trace;
+    trace_run = run;
+    const ExactTaskSet& task_set = trace.runs[run].task_set;
+    trace_time_scale = tickScale(task_set);
+    trace_task_set.clear();
+    for (const auto& task : task_set)
+        trace_task_set.emplace_back(toTime(task.phase, trace_time_scale), toTime(task.period, trace_time_scale), toTime(task.exec_time, trace_time_scale), toTime(task.relative_deadline, trace_time_scale));
+    pages.clear();
+    blocks.clear();
+}
+
+void Visualizer::update(const MouseState& mouse, float fps) {
+    pageIn();
+    draw(trace_task_set, trace->runs[trace_run].cores, trace_time_scale, mouse, fps);
+}
+
+void Visualizer::pageIn() {
+    // zoomed far out only every stride-th segment is shown so memory stays bounded
+    const int MAX_PAGES = 64;
+    double left = (tf.inv() * Pos(0.f, 0.f)).x;
+    double right = (tf.inv() * Pos(window.getSize())).x;
+    std::pair<int, int> range = trace->segmentRange(trace_run, left, right);
+    int stride = std::max(1, (range.second - range.first + MAX_PAGES) / MAX_PAGES);
+    std::map<int, std::vector<ExecBlock>> shown;
+    bool changed = false;
+    for (int i = range.first; i <= range.second; i += stride) {
+        auto page = pages.find(i);
+        if (page != pages.end()) {
+            shown[i].swap(page->second);
+            pages.erase(page);
+        } else {
+            trace->segmentBlocks(trace_run, i, trace_time_scale, shown[i]);
+            changed = true;
+        }
+    }
+    changed = changed || !pages.empty() || blocks.size() != trace_task_set.size();
+    pages.swap(shown);
+    if (!changed) return;
+
+    // rebuild the rows from the shown pages, joining blocks split across segments
+    blocks.clear();
+    blocks.resize(trace_task_set.size());
+    for (const auto& page : pages) {
+        for (ExecBlock block : page.second) {
+            std::vector<ExecBlockView>& task_blocks = blocks[block.task_id];
+            if (!task_blocks.empty()) {
+                const ExecBlock& backBlock = task_blocks.back().block;
+                if (backBlock.end == block.start && backBlock.job_id == block.job_id && backBlock.core == block.core) {
+                    block.start = backBlock.start;
+                    task_blocks.pop_back();
+                }
+            }
+            task_blocks.emplace_back(block, 1.f / (float)trace_time_scale);
+        }
+    }
+}
+
+void Visualizer::draw(TaskSet& task_set, int cores, long long time_scale, const MouseState& mouse, float fps) {
     window.setView(sf::View(sf::FloatRect(0.f, 0.f, window.getSize().x, window.getSize().y)));
 
     // draw background grid
@@ -49,21 +129,6 @@ void Visualizer::update(SimModel& model, const MouseState& mouse, float fps) {
         grid_pos += offset;
     }
 
-    // handle new exec blocks
-    blocks.resize(model.task_set.size());
-    while (model.ebs.hasNext()) {
-        ExecBlock block = model.ebs.getNext();
-        std::vector<ExecBlockView>& task_blocks = blocks[block.task_id];
-        if (!task_blocks.empty()) {
-            const ExecBlock& backBlock = task_blocks.back().block;
-            if (backBlock.end == block.start && backBlock.job_id == block.job_id && backBlock.core == block.core) {
-                block.start = backBlock.start;
-                task_blocks.pop_back();
-            }
-        }
-        blocks[block.task_id].emplace_back(block);
-    }
-
     // helper function to find first and last block in range using bsearch
     auto taskViewBounds = [&](std::vector<ExecBlockView>& task_blocks, float left, float right) {
         int start, end;
@@ -91,9 +156,9 @@ void Visualizer::update(SimModel& model, const MouseState& mouse, float fps) {
     };
 
     // figure out which blocks are being hovered on
-    Transform core_tracks_offset = Transform::trans(0.f, BLOCK_SPACING * (model.task_set.size() + 1));
+    Transform core_tracks_offset = Transform::trans(0.f, BLOCK_SPACING * (task_set.size() + 1));
     int hover_tid = -1, hover_jid = -1;
-    for (int tid = 0; hover_tid == -1 && tid < model.task_set.size(); ++tid) {
+    for (int tid = 0; hover_tid == -1 && tid < task_set.size(); ++tid) {
         std::vector<ExecBlockView>& task_blocks = blocks[tid];
         if (task_blocks.empty()) continue;
         std::pair<int,int> bounds = taskViewBounds(task_blocks, mouse.pos.x, mouse.pos.x);
@@ -108,7 +173,7 @@ void Visualizer::update(SimModel& model, const MouseState& mouse, float fps) {
     std::vector<ExecBlockView*> focused_block_views;
     Transform tasks_tf = tf;
     Transform cores_tf = tf * core_tracks_offset;
-    for (int tid = 0; tid < model.task_set.size(); ++tid) {
+    for (int tid = 0; tid < task_set.size(); ++tid) {
         std::vector<ExecBlockView>& task_blocks = blocks[tid];
         if (task_blocks.empty()) continue;
         std::pair<int,int> bounds = taskViewBounds(task_blocks, 0, window.getSize().x);
@@ -130,12 +195,13 @@ void Visualizer::update(SimModel& model, const MouseState& mouse, float fps) {
     }
 
     // draw ui
-    task_editors.resize(model.task_set.size());
-    task_labels.resize(model.task_set.size());
-    for (int tid = 0; tid < model.task_set.size(); ++tid) {
-        Task& task = model.task_set[tid];
-        task_editors[tid].draw(window, tf, model.task_set[tid], tid);
-        auto frac_str = [](Fraction frac) {
+    task_editors.resize(task_set.size());
+    task_labels.resize(task_set.size());
+    for (int tid = 0; tid < task_set.size(); ++tid) {
+        Task& task = task_set[tid];
+        task_editors[tid].draw(window, tf, task_set[tid], tid);
+        auto frac_str = [time_scale](Time t) {
+            Fraction frac = Fraction(t) / time_scale;
             return frac.isInt() ? std::to_string(frac.getNum()) : std::to_string(frac.getNum()) + "/" + std::to_string(frac.getDen());
         };
         std::string task_label = "task " + std::to_string(tid+1)
@@ -147,8 +213,8 @@ void Visualizer::update(SimModel& model, const MouseState& mouse, float fps) {
         task_labels[tid].draw(window, tasks_tf * Transform::scale(tasks_tf.sx() / tasks_tf.sy(), 1).inv());
     }
 
-    core_labels.resize(model.cores);
-    for (int i = 0; i < model.cores; ++i) {
+    core_labels.resize(cores);
+    for (int i = 0; i < cores; ++i) {
         std::string core_label = "core " + std::to_string(i+1);
         task_labels[i] = TextBox(Pos(-55, i * BLOCK_SPACING + 0.5f), Pos(50, BLOCK_SPACING - 0.5f), 2.5f, core_label, true);
         task_labels[i].draw(window, cores_tf * Transform::scale(cores_tf.sx() / cores_tf.sy(), 1).inv());
@@ -181,7 +247,7 @@ void Visualizer::move(float dx, float dy) {
 }
 
 float ExecBlockView::getX() const {
-    return *block.start;
+    return toFloat(block.start) * time_unit;
 }
 
 float ExecBlockView::getY(bool task_based) const {
@@ -189,7 +255,7 @@ float ExecBlockView::getY(bool task_based) const {
 }
 
 float ExecBlockView::getWidth() const {
-    return (float)(*block.end - *block.start);
+    return (toFloat(block.end) - toFloat(block.start)) * time_unit;
 }
 
 float ExecBlockView::getHeight() const {
@@ -231,6 +297,8 @@ void ExecBlockView::draw(sf::RenderWindow& window, Transform tf, bool task_based
     Pos blockPos = tf * getPos(task_based);
     rect.move(*blockPos);
     sf::Color color = hue((task_based ? block.job_id : block.task_id) / 12.f, 0.25f, (float)fc);
+    if (block.endState == ExecBlock::OVERHEAD) // switching overhead in grey
+        color = sf::Color(fc / 2, fc / 2, fc / 2);
     if (std::min(rect.getSize().x, rect.getSize().y) <= BLOCK_OUTLINE * 2.f) {
         rect.setFillColor(color);
         window.draw(rect);
@@ -282,6 +350,8 @@ void ExecBlockView::draw(sf::RenderWindow& window, Transform tf, bool task_based
         case ExecBlock::MISSED: {
 
         } break;
+        case ExecBlock::OVERHEAD:
+            break;
     }
 }
 
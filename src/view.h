@@ -3,9 +3,11 @@
 
 #include <SFML/Graphics.hpp>
 #include "model.h"
+#include "trace.h"
 #include <utility>
 #include <string>
 #include <unordered_map>
+#include <map>
 
 const float MAX_ZOOM = 10000.f;
 const float MIN_ZOOM = 0.5f;
@@ -187,12 +189,13 @@ struct ExecBlockView {
     static void init(sf::Font font);
 
     const ExecBlock block;
+    const float time_unit; // task set time units per model time unit (1 / SimModel::time_scale)
     std::string label;
 
     MouseRegion task_mr;
     MouseRegion core_mr;
 
-    ExecBlockView(ExecBlock block) : block(block) {
+    ExecBlockView(ExecBlock block, float time_unit) : block(block), time_unit(time_unit) {
         label = std::to_string(block.task_id+1) + "," + std::to_string(block.job_id+1);
     }
 
@@ -213,6 +216,14 @@ struct Visualizer {
     sf::RenderWindow window;
     Transform tf = Transform::scale(START_ZOOM, START_ZOOM);
     std::vector<std::vector<ExecBlockView>> blocks;
+    std::vector<ExecBlock> drained; // new exec blocks read from the model each update
+
+    // trace replay, blocks come from the segments of the run that are on screen
+    const TraceFile* trace = nullptr;
+    int trace_run = 0;
+    TaskSet trace_task_set;
+    long long trace_time_scale = 1;
+    std::map<int, std::vector<ExecBlock>> pages; // segment -> its exec blocks
 
     std::vector<TaskEditor> task_editors;
     std::vector<TextBox> task_labels;
@@ -237,6 +248,19 @@ struct Visualizer {
 
     // updates display
     void update(SimModel& model, const MouseState& mouse, float fps);
+
+    // show a run of a trace file instead of a live model (trace must stay open while shown)
+    void replay(const TraceFile& trace, int run);
+
+    // updates display from the replayed trace
+    void update(const MouseState& mouse, float fps);
+
+private:
+    // decode the segments in view and drop the rest
+    void pageIn();
+
+    // draw blocks and labels
+    void draw(TaskSet& task_set, int cores, long long time_scale, const MouseState& mouse, float fps);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "model.h"
+#include "taskgen.h"
+#include "schedulers/schedulers.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+// steady state decisions should not touch the heap: each scheduler is warmed up on a task set,
+// then heap allocations are counted over further runs, under every miss policy and with incremental scheduling where supported
+// prints each run that allocated, fails unless the total is 0
+
+// heap allocations made while counting_allocations is set
+// replaces the global operator new, array and nothrow forms go through it
+static std::atomic<bool> counting_allocations(false);
+static std::atomic<long long> allocation_count(0);
+
+void* operator new(std::size_t size) {
+    if (counting_allocations.load(std::memory_order_relaxed))
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+static long long countAllocations(int cores) {
+    const int TRIALS = 3;
+    const int PRECISION = 1000;
+    const int TASK_COUNT = 8;
+    const int MIN_PERIOD = 4;
+    const int MAX_PERIOD = 12;
+    const int WARMUP_TIME = 2000;
+    const int STEPS = 40;
+    const int STEP_TIME = 5;
+    const int SCHED_COUNT = 8;
+    const int PD2_SCALE = 10;
+
+    GEDF gedf; GDM gdm; GFIFO gfifo; EDZL edzl; PD2 pd2(true); GLLF gllf; LLREF llref; UEDF uedf;
+    Scheduler* schedulers[SCHED_COUNT] = {&gedf, &gdm, &gfifo, &edzl, &pd2, &gllf, &llref, &uedf};
+    std::string scheduler_names[SCHED_COUNT] = {"GEDF", "GDM", "GFIFO", "EDZL", "PD2", "GLLF", "LLREF", "U-EDF"};
+    bool quantum[SCHED_COUNT] = {false, false, false, false, true, true, false, false};
+    // LLREF and U-EDF need exact time, they are left out with MARISA_TICK_TIME
+    bool skipped[SCHED_COUNT] = {false, false, false, false, false, false, !EXACT_TIME, !EXACT_TIME};
+    std::string policy_names[3] = {"abort", "continue", "drop"}; // by SimModel::MissPolicy
+    long long total = 0;
+
+    for (int trial = 0; trial < TRIALS; ++trial) {
+        ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(PRECISION, Fraction(cores * (trial + 7), 10), TASK_COUNT, MIN_PERIOD, MAX_PERIOD);
+        // quantum based schedulers need whole time units
+        ExactTaskSet quantum_task_set;
+        for (auto task : task_set) {
+            task.exec_time = (task.exec_time * PD2_SCALE).ceil();
+            task.period = task.period * PD2_SCALE;
+            task.relative_deadline = task.period;
+            quantum_task_set.push_back(task);
+        }
+        for (int i = 0; i < SCHED_COUNT; ++i) {
+            if (skipped[i]) continue;
+            for (int policy = 0; policy < 3; ++policy) {
+                for (int incremental = 0; incremental < 2; ++incremental) {
+                    if (incremental && !schedulers[i]->incremental()) continue;
+                    SimModel model;
+                    model.ebs_active = false;
+                    model.keep_finished_jobs = false;
+                    model.use_incremental = incremental;
+                    model.miss_policy = (SimModel::MissPolicy)policy;
+                    model.reset(quantum[i] ? quantum_task_set : task_set, schedulers[i], cores);
+
+                    // the first runs size the scratch pool, job slots and event queue
+                    Fraction time = WARMUP_TIME;
+                    model.sim(time);
+                    allocation_count = 0;
+                    counting_allocations = true;
+                    for (int step = 0; step < STEPS; ++step)
+                        model.sim(time += STEP_TIME);
+                    counting_allocations = false;
+
+                    long long allocated = allocation_count;
+                    total += allocated;
+                    if (allocated != 0)
+                        std::cout << cores << " cores " << scheduler_names[i] << " trial=" << trial << " policy=" << policy_names[policy] << " incremental=" << incremental << ": " << allocated << std::endl;
+                }
+            }
+        }
+    }
+    return total;
+}
+
+int main() {
+    long long total = 0;
+    for (int cores : {2, 4})
+        total += countAllocations(cores);
+    std::cout << "ALLOCATIONS " << total << std::endl;
+    return total == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "model.h"
+#include "taskgen.h"
+#include "schedulers/schedulers.h"
+
+#include <iostream>
+#include <numeric>
+
+// runs that once broke, each check prints what went wrong and returns false
+
+// Fraction operands past the lazy normalization limit still share factors, the slow paths must reduce them before giving up
+static bool fractionSlowPath() {
+    Fraction a = Fraction(1, 1ll << 32) * 4; // kept as 4/2^32
+    Fraction b = Fraction(1, (1ll << 32) - 1) * 3; // kept as 3/(2^32-1)
+    bool ok = true;
+    try {
+        ok = ok && a + b == Fraction(2505397589ll, 1537228672451215360ll);
+        ok = ok && a * b == Fraction(1, 1537228672451215360ll);
+    } catch (const std::overflow_error&) {
+        ok = false;
+    }
+    ok = ok && Fraction(-4, 2).ceil() == -2 && Fraction(-1, 2).floor() == -1 && Fraction(-1, 2).ceil() == 0;
+    ok = ok && (Fraction(LLONG_MAX - 1) * Fraction(1, 1ll << 32)).ceil() == (LLONG_MAX - 1) / (1ll << 32) + 1; // num + den - 1 would overflow
+    if (!ok)
+        std::cout << "fractionSlowPath: wrong result" << std::endl;
+    return ok;
+}
+
+// U-EDF under SimModel::CONTINUE on overloaded single core sets, budgets used to be allocated past the last core
+static bool uedfOverload() {
+    if (!EXACT_TIME) return true; // U-EDF needs exact time
+    bool ok = true;
+    for (int seed = 0; seed < 15; ++seed) {
+        TaskSetGenerator::gen.seed(seed);
+        ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(1000, Fraction(3, 2), 6, 4, 12);
+        UEDF scheduler;
+        SimModel model;
+        model.miss_policy = SimModel::CONTINUE;
+        model.reset(task_set, &scheduler, 1);
+        model.sim(200);
+        long long misses = 0;
+        for (const TardinessStats& task : model.task_stats)
+            misses += task.misses;
+        if (model.stats.count == 0 || misses == 0) {
+            std::cout << "uedfOverload seed=" << seed << ": " << model.stats.count << " completed, " << misses << " missed" << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// EDZL's incremental decisions against its full schedule once jobs run late or are dropped
+// SimModel::verify_incremental asserts they match, so this needs asserts on
+static bool edzlLateVerify() {
+    for (int cores : {1, 2, 4}) {
+        for (SimModel::MissPolicy policy : {SimModel::CONTINUE, SimModel::DROP}) {
+            for (int seed = 0; seed < 50; ++seed) {
+                TaskSetGenerator::gen.seed(seed);
+                ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(1000, Fraction(11 * cores, 10), 6 * cores, 4, 12);
+                EDZL scheduler;
+                SimModel model;
+                model.miss_policy = policy;
+                model.use_incremental = true;
+                model.verify_incremental = true;
+                model.reset(task_set, &scheduler, cores);
+                model.sim(200);
+            }
+        }
+    }
+    return true;
+}
+
+// Experiment::sched flow: simulate to SIM_TIME without detection, then check to 2H with it on
+// a schedulable set whose hyperperiod is past SIM_TIME must stop a hyperperiod after detection starts
+static bool steadyStateAfterWarmup() {
+    const int SIM_TIME = 1000;
+    bool ok = true;
+    int checked = 0;
+    for (int seed = 0; seed < 30; ++seed) {
+        TaskSetGenerator::gen.seed(seed);
+        ExactTaskSet task_set = TaskSetGenerator::genModifiedKraemer(20000, Fraction(2), 12, 4, 12);
+        long long hyperperiod = 1;
+        for (auto& task : task_set)
+            hyperperiod = std::lcm(hyperperiod, task.period.getNum());
+        if (hyperperiod <= SIM_TIME) continue;
+        GEDF scheduler;
+        SimModel model;
+        model.ebs_active = false;
+        model.keep_finished_jobs = false;
+        model.reset(task_set, &scheduler, 4);
+        model.detect_steady_state = false;
+        model.sim(SIM_TIME);
+        model.detect_steady_state = true;
+        model.sim(hyperperiod * 2);
+        ++checked;
+        Fraction stop = model.toExact(model.origin + model.time);
+        if (model.verdict() != SimModel::SCHEDULABLE || stop >= hyperperiod * 2) {
+            std::cout << "steadyStateAfterWarmup seed=" << seed << ": verdict " << model.verdict() << " at t=" << *stop << " (H=" << hyperperiod << ")" << std::endl;
+            ok = false;
+        }
+    }
+    return ok && checked > 0;
+}
+
+int main() {
+    bool ok = true;
+    ok = fractionSlowPath() && ok;
+    ok = uedfOverload() && ok;
+    ok = edzlLateVerify() && ok;
+    ok = steadyStateAfterWarmup() && ok;
+    std::cout << (ok ? "PASSED" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file